@@ -152,10 +152,17 @@ namespace wiz {
 
     template <>
     void FwdDeleter<Expression>::operator()(const Expression* ptr) {
-        delete ptr;
+        // Shared nodes belong to their expression cache.
+        if (ptr != nullptr && !ptr->shared) {
+            ptr->~Expression();
+            Arena::deallocate(ptr, sizeof(Expression));
+        }
     }
 
     FwdUniquePtr<const Expression> Expression::clone() const {
+        if (shared) {
+            return FwdUniquePtr<const Expression>(this);
+        }
         return clone(location, info ? info->clone() : Optional<ExpressionInfo>());
     }
 
@@ -258,6 +265,12 @@ namespace wiz {
                         offsetOf.field),
                     location, std::move(info));
             }
+            case VariantType::typeIndexOf<PackedArrayLiteral>(): {
+                const auto& packedArrayLiteral = variant.get<PackedArrayLiteral>();
+                return makeFwdUnique<const Expression>(
+                    PackedArrayLiteral(packedArrayLiteral.buffer, packedArrayLiteral.elementType),
+                    location, std::move(info));
+            }
             case VariantType::typeIndexOf<RangeLiteral>(): {
                 const auto& rangeLiteral = variant.get<RangeLiteral>();
                 return makeFwdUnique<const Expression>(
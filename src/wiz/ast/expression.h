@@ -11,6 +11,7 @@
 
 #include <wiz/ast/qualifiers.h>
 #include <wiz/utility/int128.h>
+#include <wiz/utility/arena.h>
 #include <wiz/utility/variant.h>
 #include <wiz/utility/optional.h>
 #include <wiz/utility/bit_flags.h>
@@ -258,6 +259,23 @@ namespace wiz {
                 StringView field;
             };
 
+            // A compile-time array of sized integers, stored as one contiguous buffer instead of a node per item.
+            // Items are packed little-endian, using the storage size of the element type.
+            struct PackedArrayLiteral {
+                PackedArrayLiteral(
+                    std::shared_ptr<const std::vector<std::uint8_t>> buffer,
+                    Definition* elementType)
+                : buffer(std::move(buffer)),
+                data(reinterpret_cast<const char*>(this->buffer->data()), this->buffer->size()),
+                elementType(elementType) {}
+
+                // Owned by the literal and shared by its copies, so an intermediate result is released as soon as nothing uses it anymore.
+                std::shared_ptr<const std::vector<std::uint8_t>> buffer;
+                // The contents of the buffer.
+                StringView data;
+                Definition* elementType;
+            };
+
             struct RangeLiteral {
                 RangeLiteral(
                     FwdUniquePtr<const Expression> start,
@@ -369,7 +387,8 @@ namespace wiz {
                 Optional<ExpressionInfo> info)
             : variant(std::forward<T>(variant)),
             location(location),
-            info(std::move(info)) {}
+            info(std::move(info)),
+            shared(false) {}
 
             FwdUniquePtr<const Expression> clone() const;
             FwdUniquePtr<const Expression> clone(SourceLocation location, Optional<ExpressionInfo> info) const;
@@ -398,6 +417,7 @@ namespace wiz {
                 Identifier,
                 IntegerLiteral,
                 OffsetOf,
+                PackedArrayLiteral,
                 RangeLiteral,
                 ResolvedIdentifier,
                 SideEffect,
@@ -412,7 +432,14 @@ namespace wiz {
             VariantType variant;
             SourceLocation location;
             Optional<ExpressionInfo> info;
+
+            // Set on nodes owned by an ExpressionCache. These are never destroyed through a FwdUniquePtr, and clone() just returns the node itself.
+            bool shared;
     };
+
+    // Expressions are still owned by FwdUniquePtrs, but their storage comes from the current arena, and is released all at once with it.
+    template <>
+    struct FwdAllocator<Expression> : ArenaFwdAllocator<Expression> {};
 }
 
 #endif
@@ -8,7 +8,10 @@
 namespace wiz {
     template<>
     void FwdDeleter<Statement>::operator()(const Statement* ptr) {
-        delete ptr;
+        if (ptr != nullptr) {
+            ptr->~Statement();
+            Arena::deallocate(ptr, sizeof(Statement));
+        }
     }
 
     FwdUniquePtr<const Statement> Statement::clone() const {
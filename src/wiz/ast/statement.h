@@ -8,6 +8,7 @@
 #include <cstddef>
 
 #include <wiz/ast/qualifiers.h>
+#include <wiz/utility/arena.h>
 #include <wiz/utility/variant.h>
 #include <wiz/utility/bit_flags.h>
 #include <wiz/utility/fwd_unique_ptr.h>
@@ -474,6 +475,10 @@ namespace wiz {
             VariantType variant;
             SourceLocation location;
     };
+
+    // Like expressions, statements live in the current arena.
+    template <>
+    struct FwdAllocator<Statement> : ArenaFwdAllocator<Statement> {};
 }
 
 #endif
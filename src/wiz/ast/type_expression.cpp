@@ -5,10 +5,17 @@
 namespace wiz {
     template <>
     void FwdDeleter<TypeExpression>::operator()(const TypeExpression* ptr) {
-        delete ptr;
+        // Interned types belong to their type table.
+        if (ptr != nullptr && ptr->canonical == nullptr) {
+            ptr->~TypeExpression();
+            Arena::deallocate(ptr, sizeof(TypeExpression));
+        }
     }
 
     FwdUniquePtr<const TypeExpression> TypeExpression::clone() const {
+        if (canonical != nullptr) {
+            return FwdUniquePtr<const TypeExpression>(this);
+        }
         switch (variant.index()) {
             case VariantType::typeIndexOf<Array>(): {
                 const auto& arrayType = variant.get<Array>();
@@ -6,6 +6,7 @@
 #include <cstddef>
 
 #include <wiz/ast/qualifiers.h>
+#include <wiz/utility/arena.h>
 #include <wiz/utility/variant.h>
 #include <wiz/utility/bit_flags.h>
 #include <wiz/utility/fwd_unique_ptr.h>
@@ -14,6 +15,7 @@
 namespace wiz {
     struct Expression;
     struct Definition;
+    struct CanonicalType;
 
     struct TypeExpression {
         public:
@@ -109,7 +111,8 @@ namespace wiz {
                 T&& variant,
                 SourceLocation location)
             : variant(std::forward<T>(variant)),
-            location(location) {}
+            location(location),
+            canonical(nullptr) {}
 
             FwdUniquePtr<const TypeExpression> clone() const;
 
@@ -126,6 +129,13 @@ namespace wiz {
 
             VariantType variant;
             SourceLocation location;
+
+            // Set on nodes owned by a TypeTable, which are immutable and shared instead of cloned.
+            // Every interned type with the same structure points at the same CanonicalType, regardless of location.
+            CanonicalType* canonical;
     };
+
+    template <>
+    struct FwdAllocator<TypeExpression> : ArenaFwdAllocator<TypeExpression> {};
 }
 #endif
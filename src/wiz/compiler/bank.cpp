@@ -1,5 +1,7 @@
+#include <algorithm>
+#include <iterator>
+
 #include <wiz/compiler/bank.h>
-#include <wiz/compiler/ir_node.h>
 #include <wiz/utility/report.h>
 #include <wiz/utility/int128.h>
 #include <wiz/utility/writer.h>
@@ -44,8 +46,7 @@ namespace wiz {
     origin(origin),
     relativePosition(0),
     capacity(capacity),
-    data(isBankKindStored(kind) ? capacity : 0, padValue),
-    ownership(capacity) {}
+    data(isBankKindStored(kind) ? capacity : 0, padValue) {}
 
     Bank::~Bank() {}
 
@@ -89,6 +90,14 @@ namespace wiz {
         relativePosition = 0;
     }
 
+    void Bank::saveReservations() {
+        savedOwnership = ownership;
+    }
+
+    void Bank::restoreReservations() {
+        ownership = savedOwnership;
+    }
+
     bool Bank::reserveRam(Report* report, StringView description, const void* node, SourceLocation location, std::size_t size) {
         if (!isBankKindWritable(kind)) {
             report->error(description.toString() + " requires a writable region, which is not allowed in readonly bank `" + name.toString() + "`", location, ReportErrorFlags::of<ReportErrorFlagType::Fatal>());
@@ -107,8 +116,18 @@ namespace wiz {
         }
     }
 
-    bool Bank::write(Report* report, StringView description, const void* node, SourceLocation location, const std::vector<std::uint8_t>& values) {
+    bool Bank::write(Report* report, StringView description, const void* node, SourceLocation location, ArrayView<std::uint8_t> values) {
         const auto size = values.size();
+        std::uint8_t* dest = nullptr;
+        if (beginWrite(report, description, node, location, size, dest)) {
+            std::copy(values.begin(), values.end(), dest);
+            endWrite(size);
+            return true;
+        }
+        return false;
+    }
+
+    bool Bank::beginWrite(Report* report, StringView description, const void* node, SourceLocation location, std::size_t size, std::uint8_t*& dest) {
         if (relativePosition + size > capacity) {
             report->error(description.toString() + " needs " + std::to_string(size)
                 + " byte(s), which exceeds the remaining space in bank `" + name.toString()
@@ -128,29 +147,36 @@ namespace wiz {
         }
 
         const auto ownerID = match->second;
-        for (std::size_t i = 0; i != size; ++i) {
-            if (ownership[relativePosition + i] != ownerID) {
-                report->error("write conflict encountered at " + getAddressDescription(relativePosition + i)
-                    + " while attempting to write byte " + std::to_string(i) + " of " + std::to_string(size)
+        const auto end = relativePosition + size;
+        auto offset = relativePosition;
+        for (auto it = findOwnershipRun(relativePosition); offset != end; ++it) {
+            const auto ownerFound = it != ownership.end() && it->first <= offset;
+            if (!ownerFound || it->second.ownerID != ownerID) {
+                report->error("write conflict encountered at " + getAddressDescription(offset)
+                    + " while attempting to write byte " + std::to_string(offset - relativePosition) + " of " + std::to_string(size)
                     + " byte(s) for " + description.toString(),
                     location, ReportErrorFlags::of<ReportErrorFlagType::InternalError, ReportErrorFlagType::Continued>());
 
-                if (const auto previousID = ownership[relativePosition + i]) {
-                    const auto& previous = owners[previousID - 1];
+                if (ownerFound) {
+                    const auto& previous = owners[it->second.ownerID - 1];
                     report->error("address was supposed to be reserved here, by " + previous.description.toString(), previous.location, ReportErrorFlags::of<ReportErrorFlagType::Fatal>());
                 } else {
                     report->error("address was never reserved when it was supposed to be", location, ReportErrorFlags::of<ReportErrorFlagType::Fatal>());
                 }
                 return false;
             }
-        }
 
-        for (const auto& value : values) {
-            data[relativePosition++] = value;
+            offset = std::min(it->second.end, end);
         }
+
+        dest = data.data() + relativePosition;
         return true;
     }
 
+    void Bank::endWrite(std::size_t size) {
+        relativePosition += size;
+    }
+
     bool Bank::absoluteSeek(Report* report, std::size_t dest, const SourceLocation& location) {
         if (origin.hasValue()) {
             const auto originValue = origin.get();
@@ -173,12 +199,10 @@ namespace wiz {
     }
 
     std::size_t Bank::calculateUsedSize() const {
-        for (std::size_t i = ownership.size() - 1; i < ownership.size(); --i) {
-            if (ownership[i] != 0) {
-                return i + 1;
-            }
+        if (ownership.empty()) {
+            return 0;
         }
-        return 0;
+        return ownership.rbegin()->second.end;
     }
 
     std::string Bank::getAddressDescription(std::size_t offset) {
@@ -208,21 +232,57 @@ namespace wiz {
             ownerID = match->second;
         }
 
-        for (std::size_t i = 0; i != size; ++i) {
-            if (const auto previousID = ownership[relativePosition + i]) {
-                const auto& previous = owners[previousID - 1];
-                report->error("overlap conflict encountered at " + getAddressDescription(relativePosition + i)
-                    + " while reserving byte " + std::to_string(i) + " of " + std::to_string(size)
-                    + " byte(s) needed for " + description.toString(),
-                    location, ReportErrorFlags::of<ReportErrorFlagType::Continued>());
-                report->error("address was previously reserved here, by " + previous.description.toString(), previous.location, ReportErrorFlags::of<ReportErrorFlagType::Fatal>());
-                return false;
-            }
+        if (size == 0) {
+            return true;
+        }
 
-            ownership[relativePosition + i] = ownerID;
+        const auto end = relativePosition + size;
+        const auto it = findOwnershipRun(relativePosition);
+        if (it != ownership.end() && it->first < end) {
+            const auto offset = std::max(it->first, relativePosition);
+            const auto& previous = owners[it->second.ownerID - 1];
+            report->error("overlap conflict encountered at " + getAddressDescription(offset)
+                + " while reserving byte " + std::to_string(offset - relativePosition) + " of " + std::to_string(size)
+                + " byte(s) needed for " + description.toString(),
+                location, ReportErrorFlags::of<ReportErrorFlagType::Continued>());
+            report->error("address was previously reserved here, by " + previous.description.toString(), previous.location, ReportErrorFlags::of<ReportErrorFlagType::Fatal>());
+            return false;
         }
 
-        relativePosition += size;
+        addOwnershipRun(relativePosition, end, ownerID);
+        relativePosition = end;
         return true;
     }
+
+    Bank::OwnershipMap::const_iterator Bank::findOwnershipRun(std::size_t offset) const {
+        // Find the first run that ends after the given offset.
+        auto it = ownership.upper_bound(offset);
+        if (it != ownership.begin()) {
+            const auto previous = std::prev(it);
+            if (previous->second.end > offset) {
+                return previous;
+            }
+        }
+        return it;
+    }
+
+    void Bank::addOwnershipRun(std::size_t start, std::size_t end, std::size_t ownerID) {
+        // Merge with adjacent runs that have the same owner, so consecutive reservations by one owner stay a single run.
+        const auto next = ownership.find(end);
+        if (next != ownership.end() && next->second.ownerID == ownerID) {
+            end = next->second.end;
+            ownership.erase(next);
+        }
+
+        const auto it = ownership.lower_bound(start);
+        if (it != ownership.begin()) {
+            const auto previous = std::prev(it);
+            if (previous->second.end == start && previous->second.ownerID == ownerID) {
+                previous->second.end = end;
+                return;
+            }
+        }
+
+        ownership.emplace_hint(it, start, OwnershipRun(end, ownerID));
+    }
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef WIZ_COMPILER_BANK_H
 #define WIZ_COMPILER_BANK_H
 
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -16,7 +17,6 @@
 
 namespace wiz {
     class Report;
-    struct IrNode;
 
     struct BankRegionOwner {
         BankRegionOwner()
@@ -73,16 +73,40 @@ namespace wiz {
             void setRelativePosition(std::size_t dest);
 
             void rewind();
+            // Remembers the space reserved so far, so that a layout pass over the code and data can be undone and done again.
+            void saveReservations();
+            void restoreReservations();
             bool reserveRam(Report* report, StringView description, const void* node, SourceLocation location, std::size_t size);
             bool reserveRom(Report* report, StringView description, const void* node, SourceLocation location, std::size_t size);
-            bool write(Report* report, StringView description, const void* node, SourceLocation location, const std::vector<std::uint8_t>& values);
+            bool write(Report* report, StringView description, const void* node, SourceLocation location, ArrayView<std::uint8_t> values);
+            // Checks that the next size bytes were reserved by node, and points dest at them so they can be written in place.
+            // The position only moves once endWrite() is called, so anything encoded in the meantime still sees the address it is written at.
+            bool beginWrite(Report* report, StringView description, const void* node, SourceLocation location, std::size_t size, std::uint8_t*& dest);
+            void endWrite(std::size_t size);
             bool absoluteSeek(Report* report, std::size_t dest, const SourceLocation& location);
 
             std::size_t calculateUsedSize() const;
 
         private:
+            // A contiguous run of bytes [start, end) in the bank that was reserved by a single owner.
+            struct OwnershipRun {
+                OwnershipRun(
+                    std::size_t end,
+                    std::size_t ownerID)
+                : end(end),
+                ownerID(ownerID) {}
+
+                std::size_t end;
+                std::size_t ownerID;
+            };
+
+            // Runs of owned bytes, keyed by the start offset of each run. Runs never overlap.
+            using OwnershipMap = std::map<std::size_t, OwnershipRun>;
+
             std::string getAddressDescription(std::size_t offset);
             bool reserve(Report* report, StringView description, const void* node, SourceLocation location, std::size_t size);
+            OwnershipMap::const_iterator findOwnershipRun(std::size_t offset) const;
+            void addOwnershipRun(std::size_t start, std::size_t end, std::size_t ownerID);
 
             StringView name;
             BankKind kind;
@@ -90,7 +114,8 @@ namespace wiz {
             std::size_t relativePosition;
             std::size_t capacity;
             std::vector<std::uint8_t> data;
-            std::vector<std::size_t> ownership;
+            OwnershipMap ownership;
+            OwnershipMap savedOwnership;
 
             std::unordered_map<const void*, std::size_t> nodesToOwners;
             std::vector<BankRegionOwner> owners;
@@ -26,6 +26,53 @@ namespace wiz {
             "nmi",
             "fallthrough",
         };
+
+        void collectIntegerBounds(const InstructionOperandPattern& pattern, std::vector<Int128>& bounds) {
+            const auto& variant = pattern.variant;
+            switch (variant.index()) {
+                case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::BitIndex>(): {
+                    const auto& bitIndexPattern = variant.get<InstructionOperandPattern::BitIndex>();
+                    collectIntegerBounds(*bitIndexPattern.operandPattern, bounds);
+                    collectIntegerBounds(*bitIndexPattern.subscriptPattern, bounds);
+                    break;
+                }
+                case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::Boolean>(): break;
+                case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::Capture>(): {
+                    const auto& capturePattern = variant.get<InstructionOperandPattern::Capture>();
+                    collectIntegerBounds(*capturePattern.operandPattern, bounds);
+                    break;
+                }
+                case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::Dereference>(): {
+                    const auto& dereferencePattern = variant.get<InstructionOperandPattern::Dereference>();
+                    collectIntegerBounds(*dereferencePattern.operandPattern, bounds);
+                    break;
+                }
+                case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::Index>(): {
+                    const auto& indexPattern = variant.get<InstructionOperandPattern::Index>();
+                    collectIntegerBounds(*indexPattern.operandPattern, bounds);
+                    collectIntegerBounds(*indexPattern.subscriptPattern, bounds);
+                    break;
+                }
+                case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::IntegerAtLeast>(): {
+                    const auto& atLeastPattern = variant.get<InstructionOperandPattern::IntegerAtLeast>();
+                    bounds.push_back(atLeastPattern.min);
+                    break;
+                }
+                case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::IntegerRange>(): {
+                    const auto& rangePattern = variant.get<InstructionOperandPattern::IntegerRange>();
+                    bounds.push_back(rangePattern.min);
+                    bounds.push_back(rangePattern.max + Int128(1));
+                    break;
+                }
+                case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::Register>(): break;
+                case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::Unary>(): {
+                    const auto& unPattern = variant.get<InstructionOperandPattern::Unary>();
+                    collectIntegerBounds(*unPattern.operandPattern, bounds);
+                    break;
+                }
+                default: std::abort(); break;
+            }
+        }
     }
 
     Builtins::Builtins(
@@ -66,6 +113,7 @@ namespace wiz {
         addDefineInteger("__version"_sv, Int128(version::ID));
 
         platform->reserveDefinitions(*this);
+        buildInstructionSelectionTrees();
     }
 
     Builtins::~Builtins() {}
@@ -247,34 +295,55 @@ namespace wiz {
         return result;
     }
 
-    const Instruction* Builtins::selectInstruction(const InstructionType& instructionType, std::uint32_t modeFlags, const std::vector<InstructionOperandRoot>& operandRoots) const {
-        const auto primaryInstructionsIter = primaryInstructionsByInstructionTypes.find(instructionType);
+    const Instruction* Builtins::selectInstruction(const InstructionType& instructionType, std::uint32_t modeFlags, ArrayView<InstructionOperandRoot> operandRoots) const {
+        const auto selectionIter = instructionSelectionsByInstructionTypes.find(instructionType);
+        if (selectionIter == instructionSelectionsByInstructionTypes.end()) {
+            return nullptr;
+        }
 
-        if (primaryInstructionsIter != primaryInstructionsByInstructionTypes.end()) {
-            const auto& primaryInstructions = primaryInstructionsIter->second;
+        const auto& selection = selectionIter->second;
 
-            for (const auto primaryInstruction : primaryInstructions) {
-                if (primaryInstruction->signature.matches(modeFlags, operandRoots)) {
-                    auto bestInstruction = primaryInstruction;
-                    retry: {
-                        const auto specializationsIter = specializationsByInstructions.find(bestInstruction);
-                        if (specializationsIter != specializationsByInstructions.end()) {
-                            const auto& specializations = specializationsIter->second;
-                            for (const auto specialization : specializations) {
-                                if (specialization->signature.matches(modeFlags, operandRoots)) {
-                                    bestInstruction = specialization;
-                                    goto retry;
-                                }
-                            }
-                        }
-                    }
-                    
-                    return bestInstruction;
-                }
+        // Operands with the same shape will always select the same instruction, so check if this was already seen.
+        auto& shape = tempInstructionShape;
+        shape.clear();
+        shape.push_back(modeFlags);
+        shape.push_back(operandRoots.size());
+        for (const auto& operandRoot : operandRoots) {
+            appendInstructionOperandShape(selection.integerBounds, *operandRoot.operand, shape);
+        }
+
+        const auto cacheIter = selection.cache.find(shape);
+        if (cacheIter != selection.cache.end()) {
+            ++instructionSelectionCacheHits;
+            return cacheIter->second;
+        }
+
+        ++instructionSelectionCacheMisses;
+
+        auto bestInstruction = selection.primaryTree.findFirstMatch(modeFlags, operandRoots);
+        while (bestInstruction != nullptr) {
+            const auto specializationTreeIter = specializationTreesByInstructions.find(bestInstruction);
+            if (specializationTreeIter == specializationTreesByInstructions.end()) {
+                break;
+            }
+
+            if (const auto specialization = specializationTreeIter->second.findFirstMatch(modeFlags, operandRoots)) {
+                bestInstruction = specialization;
+            } else {
+                break;
             }
         }
 
-        return nullptr;
+        selection.cache.emplace(shape, bestInstruction);
+        return bestInstruction;
+    }
+
+    std::size_t Builtins::getInstructionSelectionCacheHits() const {
+        return instructionSelectionCacheHits;
+    }
+
+    std::size_t Builtins::getInstructionSelectionCacheMisses() const {
+        return instructionSelectionCacheMisses;
     }
 
     StringView Builtins::getPropertyName(Property prop) const {
@@ -331,4 +400,89 @@ namespace wiz {
     const TypeExpression* Builtins::getUnitTuple() const {
         return unitTuple.get();
     }
+
+    void Builtins::buildInstructionSelectionTrees() {
+        instructionSelectionsByInstructionTypes.clear();
+        specializationTreesByInstructions.clear();
+
+        for (const auto& item : primaryInstructionsByInstructionTypes) {
+            auto& selection = instructionSelectionsByInstructionTypes[item.first];
+            selection.primaryTree = InstructionSelectionTree(item.second);
+
+            auto& bounds = selection.integerBounds;
+            for (const auto instruction : findAllInstructionsByType(item.first)) {
+                for (const auto operandPattern : instruction->signature.operandPatterns) {
+                    collectIntegerBounds(*operandPattern, bounds);
+                }
+            }
+
+            std::sort(bounds.begin(), bounds.end());
+            bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+        }
+        for (const auto& item : specializationsByInstructions) {
+            if (!item.second.empty()) {
+                specializationTreesByInstructions.emplace(item.first, InstructionSelectionTree(item.second));
+            }
+        }
+    }
+
+    void Builtins::appendInstructionOperandShape(const std::vector<Int128>& integerBounds, const InstructionOperand& operand, std::vector<std::uintptr_t>& shape) const {
+        const auto& variant = operand.variant;
+        shape.push_back(variant.index());
+
+        switch (variant.index()) {
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::BitIndex>(): {
+                const auto& bitIndex = variant.get<InstructionOperand::BitIndex>();
+                appendInstructionOperandShape(integerBounds, *bitIndex.operand, shape);
+                appendInstructionOperandShape(integerBounds, *bitIndex.subscript, shape);
+                break;
+            }
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Binary>(): {
+                const auto& bin = variant.get<InstructionOperand::Binary>();
+                shape.push_back(static_cast<std::uintptr_t>(bin.kind));
+                appendInstructionOperandShape(integerBounds, *bin.left, shape);
+                appendInstructionOperandShape(integerBounds, *bin.right, shape);
+                break;
+            }
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Boolean>(): {
+                const auto& boolean = variant.get<InstructionOperand::Boolean>();
+                shape.push_back(boolean.value ? 1 : 0);
+                break;
+            }
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Dereference>(): {
+                const auto& dereference = variant.get<InstructionOperand::Dereference>();
+                shape.push_back(dereference.far ? 1 : 0);
+                shape.push_back(dereference.size);
+                appendInstructionOperandShape(integerBounds, *dereference.operand, shape);
+                break;
+            }
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Index>(): {
+                const auto& index = variant.get<InstructionOperand::Index>();
+                shape.push_back(index.far ? 1 : 0);
+                shape.push_back(index.size);
+                shape.push_back(index.subscriptScale);
+                appendInstructionOperandShape(integerBounds, *index.operand, shape);
+                appendInstructionOperandShape(integerBounds, *index.subscript, shape);
+                break;
+            }
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Integer>(): {
+                // Only the range bucket matters to the patterns, not the exact value.
+                const auto& integer = variant.get<InstructionOperand::Integer>();
+                shape.push_back(static_cast<std::uintptr_t>(std::upper_bound(integerBounds.begin(), integerBounds.end(), integer.value) - integerBounds.begin()));
+                break;
+            }
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Register>(): {
+                const auto& reg = variant.get<InstructionOperand::Register>();
+                shape.push_back(reinterpret_cast<std::uintptr_t>(reg.definition));
+                break;
+            }
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Unary>(): {
+                const auto& un = variant.get<InstructionOperand::Unary>();
+                shape.push_back(static_cast<std::uintptr_t>(un.kind));
+                appendInstructionOperandShape(integerBounds, *un.operand, shape);
+                break;
+            }
+            default: std::abort(); break;
+        }
+    }
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <wiz/utility/int128.h>
 #include <wiz/utility/array_view.h>
 #include <wiz/utility/fwd_unique_ptr.h>
+#include <wiz/utility/string_pool.h>
 
 namespace wiz {
     struct Statement;
@@ -114,7 +115,9 @@ namespace wiz {
             const Instruction* addInstruction(FwdUniquePtr<const Instruction> uniqueInstruction);
             std::vector<const Instruction*> findAllInstructionsByType(const InstructionType& instructionType) const;
             std::vector<const Instruction*> findAllSpecializationsByInstruction(const Instruction* instruction) const;
-            const Instruction* selectInstruction(const InstructionType& instructionType, std::uint32_t modeFlags, const std::vector<InstructionOperandRoot>& operandRoots) const;
+            const Instruction* selectInstruction(const InstructionType& instructionType, std::uint32_t modeFlags, ArrayView<InstructionOperandRoot> operandRoots) const;
+            std::size_t getInstructionSelectionCacheHits() const;
+            std::size_t getInstructionSelectionCacheMisses() const;
 
             StringView getPropertyName(Property prop) const;
             Property findPropertyByName(StringView name) const;
@@ -129,6 +132,24 @@ namespace wiz {
             const TypeExpression* getUnitTuple() const;
 
         private:
+            struct InstructionShapeHash {
+                std::size_t operator()(const std::vector<std::uintptr_t>& shape) const {
+                    return std::hash<ArrayView<std::uintptr_t>>()(ArrayView<std::uintptr_t>(shape));
+                }
+            };
+
+            struct InstructionTypeSelection {
+                InstructionSelectionTree primaryTree;
+                // Sorted bounds of every integer range in the operand patterns of this instruction type.
+                // Integers between two consecutive bounds match exactly the same patterns.
+                std::vector<Int128> integerBounds;
+                // Previously selected instructions, keyed by mode flags and operand shape.
+                mutable std::unordered_map<std::vector<std::uintptr_t>, const Instruction*, InstructionShapeHash> cache;
+            };
+
+            void buildInstructionSelectionTrees();
+            void appendInstructionOperandShape(const std::vector<Int128>& integerBounds, const InstructionOperand& operand, std::vector<std::uintptr_t>& shape) const;
+
             StringPool* stringPool = nullptr;
             Platform* platform = nullptr;
             std::unordered_map<StringView, FwdUniquePtr<const Expression>> defines;
@@ -161,9 +182,14 @@ namespace wiz {
             std::vector<FwdUniquePtr<const Instruction>> instructions;
             std::unordered_map<InstructionType, std::vector<const Instruction*>> primaryInstructionsByInstructionTypes;
             std::unordered_map<const Instruction*, std::vector<const Instruction*>> specializationsByInstructions;
+            std::unordered_map<InstructionType, InstructionTypeSelection> instructionSelectionsByInstructionTypes;
+            std::unordered_map<const Instruction*, InstructionSelectionTree> specializationTreesByInstructions;
+            mutable std::vector<std::uintptr_t> tempInstructionShape;
+            mutable std::size_t instructionSelectionCacheHits = 0;
+            mutable std::size_t instructionSelectionCacheMisses = 0;
 
             std::vector<std::unique_ptr<BuiltinModeAttribute>> modeAttributes;
-            std::unordered_map<StringView, std::size_t> modeAttributesByName;
+            InternedStringMap<std::size_t> modeAttributesByName;
     };
 }
 
@@ -1,6 +1,11 @@
 #include <cassert>
 #include <algorithm>
-#include <set>
+
+#ifndef __EMSCRIPTEN__
+#define WIZ_THREADS
+#include <atomic>
+#include <thread>
+#endif
 
 #include <wiz/compiler/compiler.h>
 
@@ -20,6 +25,7 @@
 #include <wiz/utility/reader.h>
 #include <wiz/utility/report.h>
 #include <wiz/utility/writer.h>
+#include <wiz/utility/allocation_counter.h>
 #include <wiz/utility/overload.h>
 #include <wiz/utility/scope_guard.h>
 #include <wiz/utility/import_manager.h>
@@ -45,6 +51,10 @@ namespace wiz {
 
     Compiler::~Compiler() {}
 
+    void Compiler::setJobCount(std::size_t value) {
+        jobCount = value;
+    }
+
     bool Compiler::compile() {
         return reserveDefinitions(program.get())
         && resolveDefinitionTypes()
@@ -90,6 +100,54 @@ namespace wiz {
         return builtins;
     }
 
+    const ExpressionCache& Compiler::getExpressionCache() const {
+        return expressionCache;
+    }
+
+    const TypeTable& Compiler::getTypeTable() const {
+        return typeTable;
+    }
+
+    std::size_t Compiler::getLetCacheHits() const {
+        return letCacheHits;
+    }
+
+    std::size_t Compiler::getLetCacheMisses() const {
+        return letCacheMisses;
+    }
+
+    std::size_t Compiler::getExpressionProgramCount() const {
+        return expressionProgramCount;
+    }
+
+    std::size_t Compiler::getExpressionProgramEvaluations() const {
+        return expressionProgramEvaluations;
+    }
+
+    std::size_t Compiler::getExpressionProgramFallbacks() const {
+        return expressionProgramFallbacks;
+    }
+
+    std::size_t Compiler::getEncodedInstructionCount() const {
+        return encodedInstructionCount;
+    }
+
+    std::size_t Compiler::getEncodingHeapAllocations() const {
+        return encodingHeapAllocations;
+    }
+
+    std::size_t Compiler::getLayoutPassCount() const {
+        return layoutPassCount;
+    }
+
+    std::size_t Compiler::getRelaxedBranchCount() const {
+        return relaxedBranchCount;
+    }
+
+    std::size_t Compiler::getEmittedBankCount() const {
+        return emittedBankCount;
+    }
+
     std::uint32_t Compiler::getModeFlags() const {
         return modeFlags;
     }
@@ -177,8 +235,292 @@ namespace wiz {
         letExpressionStack.pop_back();    
     }
 
+    bool Compiler::isLetCacheable(const Definition* definition) const {
+        // Argument bindings and loop variables are also lets, but their expression is swapped out from under them.
+        // Only a let whose expression is the value of its own declaration always reduces the same way.
+        if (definition->declaration == nullptr) {
+            return false;
+        }
+        if (const auto letDeclaration = definition->declaration->variant.tryGet<Statement::Let>()) {
+            return letDeclaration->value.get() == definition->variant.get<Definition::Let>().expression;
+        }
+        return false;
+    }
+
+    bool Compiler::isCacheableLetArgument(const Expression* expression) const {
+        if (expression->info->context != EvaluationContext::CompileTime) {
+            return false;
+        }
+        const auto type = expression->info->type.get();
+        if (type != nullptr && !type->variant.is<TypeExpression::ResolvedIdentifier>()) {
+            return false;
+        }
+        return expression->variant.is<Expression::IntegerLiteral>()
+            || expression->variant.is<Expression::BooleanLiteral>()
+            || expression->variant.is<Expression::StringLiteral>();
+    }
+
+    bool Compiler::isSameLetArgument(const Expression* left, const Expression* right) const {
+        if (left == right) {
+            return true;
+        }
+        if (left->variant.index() != right->variant.index()
+        || left->info->qualifiers != right->info->qualifiers
+        || (left->info->type == nullptr) != (right->info->type == nullptr)) {
+            return false;
+        }
+        if (left->info->type != nullptr
+        && left->info->type->variant.get<TypeExpression::ResolvedIdentifier>().definition != right->info->type->variant.get<TypeExpression::ResolvedIdentifier>().definition) {
+            return false;
+        }
+
+        if (const auto leftIntegerLiteral = left->variant.tryGet<Expression::IntegerLiteral>()) {
+            const auto& rightIntegerLiteral = right->variant.get<Expression::IntegerLiteral>();
+            return leftIntegerLiteral->value == rightIntegerLiteral.value && leftIntegerLiteral->suffix == rightIntegerLiteral.suffix;
+        } else if (const auto leftBooleanLiteral = left->variant.tryGet<Expression::BooleanLiteral>()) {
+            return leftBooleanLiteral->value == right->variant.get<Expression::BooleanLiteral>().value;
+        } else if (const auto leftStringLiteral = left->variant.tryGet<Expression::StringLiteral>()) {
+            return leftStringLiteral->value == right->variant.get<Expression::StringLiteral>().value;
+        }
+        return false;
+    }
+
+    FwdUniquePtr<ExpressionProgram> Compiler::compileExpressionProgram(const Expression* expression, const std::vector<StringView>& inputNames) {
+        auto program = makeFwdUnique<ExpressionProgram>(inputNames.size(),
+            builtins.getDefinition(Builtins::DefinitionType::Bool),
+            builtins.getDefinition(Builtins::DefinitionType::U8));
+
+        std::vector<std::pair<StringView, ExpressionProgram::Register>> bindings;
+        bindings.reserve(inputNames.size());
+        for (std::size_t i = 0; i != inputNames.size(); ++i) {
+            bindings.emplace_back(inputNames[i], static_cast<ExpressionProgram::Register>(i));
+        }
+
+        ExpressionProgram::Register result = 0;
+        SourceLocation resultLocation;
+        if (!compileExpressionProgramNode(*program, expression, bindings, 0, result, resultLocation)) {
+            return nullptr;
+        }
+
+        program->setResult(result, resultLocation);
+        ++expressionProgramCount;
+        return program;
+    }
+
+    bool Compiler::compileExpressionProgramNode(ExpressionProgram& program, const Expression* expression, const std::vector<std::pair<StringView, ExpressionProgram::Register>>& bindings, std::size_t depth, ExpressionProgram::Register& result, SourceLocation& resultLocation) {
+        // Only called for expressions that have already been reduced once without errors,
+        // so reducing the parts that don't depend on the inputs here won't report anything new.
+        if (program.isFull()) {
+            return false;
+        }
+
+        const auto& variant = expression->variant;
+        switch (variant.index()) {
+            case Expression::VariantType::typeIndexOf<Expression::BinaryOperator>(): {
+                const auto& binaryOperator = variant.get<Expression::BinaryOperator>();
+                const auto op = binaryOperator.op;
+                if (!isValidArithmeticOp(op) && !isValidComparisonOp(op)
+                && op != BinaryOperatorKind::LogicalAnd
+                && op != BinaryOperatorKind::LogicalOr
+                && op != BinaryOperatorKind::BitIndexing
+                && op != BinaryOperatorKind::LeftRotate
+                && op != BinaryOperatorKind::RightRotate) {
+                    return false;
+                }
+
+                ExpressionProgram::Register left = 0;
+                ExpressionProgram::Register right = 0;
+                SourceLocation operandLocation;
+                if (!compileExpressionProgramNode(program, binaryOperator.left.get(), bindings, depth, left, operandLocation)
+                || !compileExpressionProgramNode(program, binaryOperator.right.get(), bindings, depth, right, operandLocation)) {
+                    return false;
+                }
+
+                result = program.addBinaryOperator(op, left, right);
+                resultLocation = expression->location;
+                return true;
+            }
+            case Expression::VariantType::typeIndexOf<Expression::BooleanLiteral>(): break;
+            case Expression::VariantType::typeIndexOf<Expression::Call>(): {
+                // `let` function calls are inlined, with the parameters bound to the registers holding the arguments.
+                const auto& call = variant.get<Expression::Call>();
+                const auto identifier = call.function->variant.tryGet<Expression::Identifier>();
+                if (call.inlined || identifier == nullptr || depth >= MaxExpressionProgramCallDepth) {
+                    return false;
+                }
+                for (const auto& binding : bindings) {
+                    if (binding.first == identifier->pieces[0]) {
+                        return false;
+                    }
+                }
+
+                const auto function = reduceExpression(call.function.get());
+                if (function == nullptr) {
+                    return false;
+                }
+                const auto resolvedIdentifier = function->variant.tryGet<Expression::ResolvedIdentifier>();
+                if (resolvedIdentifier == nullptr) {
+                    return false;
+                }
+
+                const auto definition = resolvedIdentifier->definition;
+                const auto letDefinition = definition->variant.tryGet<Definition::Let>();
+                if (letDefinition == nullptr
+                || letDefinition->expression == nullptr
+                || letDefinition->parameters.size() != call.arguments.size()
+                || definition == builtins.getDefinition(Builtins::DefinitionType::HasDef)
+                || definition == builtins.getDefinition(Builtins::DefinitionType::GetDef)) {
+                    return false;
+                }
+
+                std::vector<std::pair<StringView, ExpressionProgram::Register>> letBindings;
+                letBindings.reserve(call.arguments.size());
+                for (std::size_t i = 0; i != call.arguments.size(); ++i) {
+                    ExpressionProgram::Register argument = 0;
+                    SourceLocation argumentLocation;
+                    if (call.arguments[i] == nullptr
+                    || !compileExpressionProgramNode(program, call.arguments[i].get(), bindings, depth, argument, argumentLocation)) {
+                        return false;
+                    }
+                    letBindings.emplace_back(letDefinition->parameters[i], argument);
+                }
+
+                enterScope(definition->parentScope);
+                const auto success = compileExpressionProgramNode(program, letDefinition->expression, letBindings, depth + 1, result, resultLocation);
+                exitScope();
+                return success;
+            }
+            case Expression::VariantType::typeIndexOf<Expression::Cast>(): {
+                const auto& cast = variant.get<Expression::Cast>();
+                const auto destType = reduceTypeExpression(cast.type.get());
+                const auto destTypeDefinition = tryGetResolvedIdentifierTypeDefinition(destType.get());
+                if (destTypeDefinition == nullptr
+                || (!destTypeDefinition->variant.is<Definition::BuiltinIntegerType>()
+                    && !destTypeDefinition->variant.is<Definition::BuiltinIntegerExpressionType>())) {
+                    return false;
+                }
+
+                ExpressionProgram::Register operand = 0;
+                SourceLocation operandLocation;
+                if (!compileExpressionProgramNode(program, cast.operand.get(), bindings, depth, operand, operandLocation)) {
+                    return false;
+                }
+
+                result = program.addCast(destTypeDefinition, operand);
+                resultLocation = expression->location;
+                return true;
+            }
+            case Expression::VariantType::typeIndexOf<Expression::Identifier>(): {
+                const auto& pieces = variant.get<Expression::Identifier>().pieces;
+                for (const auto& binding : bindings) {
+                    if (binding.first == pieces[0]) {
+                        if (pieces.size() != 1) {
+                            return false;
+                        }
+
+                        // Like any other `let` reference, this takes the location of the reference.
+                        result = binding.second;
+                        resultLocation = expression->location;
+                        return true;
+                    }
+                }
+                break;
+            }
+            case Expression::VariantType::typeIndexOf<Expression::IntegerLiteral>(): break;
+            case Expression::VariantType::typeIndexOf<Expression::UnaryOperator>(): {
+                const auto& unaryOperator = variant.get<Expression::UnaryOperator>();
+                const auto op = unaryOperator.op;
+                switch (op) {
+                    case UnaryOperatorKind::Grouping: {
+                        return compileExpressionProgramNode(program, unaryOperator.operand.get(), bindings, depth, result, resultLocation);
+                    }
+                    case UnaryOperatorKind::BitwiseNegation:
+                    case UnaryOperatorKind::LogicalNegation:
+                    case UnaryOperatorKind::SignedNegation:
+                    case UnaryOperatorKind::LowByte:
+                    case UnaryOperatorKind::HighByte:
+                    case UnaryOperatorKind::BankByte: {
+                        ExpressionProgram::Register operand = 0;
+                        SourceLocation operandLocation;
+                        if (!compileExpressionProgramNode(program, unaryOperator.operand.get(), bindings, depth, operand, operandLocation)) {
+                            return false;
+                        }
+
+                        result = program.addUnaryOperator(op, operand);
+                        resultLocation = expression->location;
+                        return true;
+                    }
+                    default: return false;
+                }
+            }
+            default: return false;
+        }
+
+        // Literals, and identifiers that aren't bound to an input, have the same value on every evaluation.
+        const auto constant = reduceExpression(expression);
+        ExpressionProgram::Value value;
+        if (constant == nullptr || !tryGetExpressionProgramValue(constant.get(), value)) {
+            return false;
+        }
+
+        result = program.addConstant(value);
+        resultLocation = constant->location;
+        return true;
+    }
+
+    bool Compiler::tryGetExpressionProgramValue(const Expression* expression, ExpressionProgram::Value& value) const {
+        if (!expression->info.hasValue()
+        || expression->info->context != EvaluationContext::CompileTime
+        || expression->info->qualifiers != Qualifiers {}) {
+            return false;
+        }
+
+        const auto typeDefinition = tryGetResolvedIdentifierTypeDefinition(expression->info->type.get());
+        if (typeDefinition == nullptr) {
+            return false;
+        }
+
+        if (const auto integerLiteral = expression->variant.tryGet<Expression::IntegerLiteral>()) {
+            if (integerLiteral->suffix.getLength() == 0
+            && (typeDefinition->variant.is<Definition::BuiltinIntegerType>()
+                || typeDefinition->variant.is<Definition::BuiltinIntegerExpressionType>())) {
+                value = ExpressionProgram::Value(typeDefinition, integerLiteral->value);
+                return true;
+            }
+        } else if (const auto booleanLiteral = expression->variant.tryGet<Expression::BooleanLiteral>()) {
+            if (typeDefinition->variant.is<Definition::BuiltinBoolType>()) {
+                value = ExpressionProgram::Value(typeDefinition, Int128(booleanLiteral->value ? 1 : 0));
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    FwdUniquePtr<const Expression> Compiler::evaluateExpressionProgram(ExpressionProgram& program) {
+        ExpressionProgram::Value value;
+        if (!program.evaluate(value)) {
+            ++expressionProgramFallbacks;
+            return nullptr;
+        }
+        ++expressionProgramEvaluations;
+
+        // Built the same way the tree reducer builds literals, and shared through the same tables.
+        const auto location = program.getResultLocation();
+        auto type = typeTable.intern(makeFwdUnique<const TypeExpression>(TypeExpression::ResolvedIdentifier(value.type), location));
+        if (value.type->variant.is<Definition::BuiltinBoolType>()) {
+            return expressionCache.intern(makeFwdUnique<const Expression>(
+                Expression::BooleanLiteral(!value.value.isZero()), location,
+                ExpressionInfo(EvaluationContext::CompileTime, std::move(type), Qualifiers {})));
+        } else {
+            return expressionCache.intern(makeFwdUnique<const Expression>(
+                Expression::IntegerLiteral(value.value), location,
+                ExpressionInfo(EvaluationContext::CompileTime, std::move(type), Qualifiers {})));
+        }
+    }
+
     Definition* Compiler::createAnonymousLabelDefinition(StringView prefix) {
-        const auto suffix = ++labelSuffixes[prefix];
+        const auto suffix = ++labelSuffixes[stringPool->intern(prefix)];
         const auto labelId = stringPool->intern(prefix.toString() + std::to_string(suffix));
         const auto result = definitionPool.addNew(Definition::Func(true, false, false, BranchKind::None, builtins.getUnitTuple(), currentScope, nullptr), labelId, nullptr);
         auto& func = result->variant.get<Definition::Func>();
@@ -211,7 +553,7 @@ namespace wiz {
             const auto piece = pieces[pieceIndex];
 
             if (previousResults.empty()) {
-                currentScope->findUnqualifiedDefinitions(piece, results);
+                results = currentScope->findUnqualifiedDefinitions(piece);
             } else {
                 for (const auto definition : previousResults) {
                     if (const auto ns = definition->variant.tryGet<Definition::Namespace>()) {
@@ -224,7 +566,7 @@ namespace wiz {
                 break;
             }
 
-            const auto firstMatch = *results.begin();
+            const auto firstMatch = results[0];
 
             if (pieceIndex == pieces.size() - 1 || !firstMatch->variant.is<Definition::Namespace>()) {
                 if (results.size() == 1) {
@@ -250,7 +592,7 @@ namespace wiz {
                 }
             }
 
-            previousResults.swap(results);
+            previousResults = results;
             results.clear();
         }
 
@@ -259,6 +601,10 @@ namespace wiz {
     }
 
     FwdUniquePtr<const TypeExpression> Compiler::reduceTypeExpression(const TypeExpression* typeExpression) {
+        return typeTable.intern(reduceTypeExpressionNode(typeExpression));
+    }
+
+    FwdUniquePtr<const TypeExpression> Compiler::reduceTypeExpressionNode(const TypeExpression* typeExpression) {
         const auto& variant = typeExpression->variant;
         switch (variant.index()) {
             case TypeExpression::VariantType::typeIndexOf<TypeExpression::Array>(): {
@@ -405,6 +751,19 @@ namespace wiz {
     }
 
     FwdUniquePtr<const Expression> Compiler::reduceExpression(const Expression* expression) {
+        auto result = reduceExpressionNode(expression);
+
+        // A freshly reduced node isn't visible to anything else yet, so its type can still be swapped for the interned one.
+        if (result != nullptr && !result->shared && result->info.hasValue()) {
+            auto& type = const_cast<Expression*>(result.get())->info->type;
+            type = typeTable.intern(std::move(type));
+        }
+
+        // Operands are reduced through here too, so sharing works bottom-up and operators only need to compare operand pointers.
+        return expressionCache.intern(std::move(result));
+    }
+
+    FwdUniquePtr<const Expression> Compiler::reduceExpressionNode(const Expression* expression) {
         const auto& variant = expression->variant;
         switch (variant.index()) {
             case Expression::VariantType::typeIndexOf<Expression::ArrayComprehension>(): {
@@ -430,13 +789,44 @@ namespace wiz {
 
                 const TypeExpression* elementType = nullptr;
 
+                // Once the first item has been reduced, the rest can usually be computed by a compiled program instead.
+                FwdUniquePtr<ExpressionProgram> program;
+
+                const auto packedSequence = reducedSequence->variant.tryGet<Expression::PackedArrayLiteral>();
+
                 for (std::size_t i = 0; i != *length; ++i) {
-                    auto sourceItem = getSequenceLiteralItem(reducedSequence.get(), i);
-                    tempLetDefinition.expression = sourceItem.get();
+                    FwdUniquePtr<const Expression> sourceItem;
+                    FwdUniquePtr<const Expression> computedItem;
+
+                    if (program != nullptr) {
+                        // Packed items are read straight into the input, without unpacking them into nodes first.
+                        ExpressionProgram::Value input;
+                        if (packedSequence != nullptr) {
+                            input = ExpressionProgram::Value(packedSequence->elementType, getPackedArrayLiteralValue(reducedSequence.get(), i));
+                        } else {
+                            sourceItem = getSequenceLiteralItem(reducedSequence.get(), i);
+                            tryGetExpressionProgramValue(sourceItem.get(), input);
+                        }
 
-                    enterScope(scope.get());
-                    auto computedItem = reduceExpression(arrayComprehension.expression.get());
-                    exitScope();
+                        if (input.type != nullptr) {
+                            program->setInput(0, input);
+                            computedItem = evaluateExpressionProgram(*program);
+                        }
+                    }
+
+                    if (computedItem == nullptr) {
+                        if (sourceItem == nullptr) {
+                            sourceItem = getSequenceLiteralItem(reducedSequence.get(), i);
+                        }
+                        tempLetDefinition.expression = sourceItem.get();
+
+                        enterScope(scope.get());
+                        computedItem = reduceExpression(arrayComprehension.expression.get());
+                        if (i == 0 && *length > 1 && computedItem != nullptr) {
+                            program = compileExpressionProgram(arrayComprehension.expression.get(), {arrayComprehension.name});
+                        }
+                        exitScope();
+                    }
 
                     if (computedItem != nullptr) {
                         if (elementType == nullptr) {
@@ -478,10 +868,26 @@ namespace wiz {
                 }
 
                 const auto length = static_cast<std::size_t>(reducedSizeLiteral->value);
+                const TypeExpression* elementType = reducedValueExpression->info->type.get();
+
+                // Padding with a sized integer writes the packed bytes directly, instead of cloning the value for every item.
+                if (const auto packedElementType = tryGetPackedElementType(elementType)) {
+                    std::vector<FwdUniquePtr<const Expression>> value;
+                    value.push_back(std::move(reducedValueExpression));
+                    if (auto packedValue = tryCreatePackedArrayLiteralExpression(value, elementType, expression->location)) {
+                        const auto valueData = packedValue->variant.get<Expression::PackedArrayLiteral>().data;
+                        std::vector<std::uint8_t> data;
+                        data.reserve(length * valueData.getLength());
+                        for (std::size_t i = 0; i != length; ++i) {
+                            data.insert(data.end(), valueData.getData(), valueData.getData() + valueData.getLength());
+                        }
+                        return createPackedArrayLiteralExpression(std::move(data), packedElementType, expression->location);
+                    }
+                    reducedValueExpression = std::move(value[0]);
+                }
+
                 std::vector<FwdUniquePtr<const Expression>> items;
                 items.reserve(length);
-
-                const TypeExpression* elementType = reducedValueExpression->info->type.get();
                 for (std::size_t i = 0; i != length; ++i) {
                     if (i == length - 1) {
                         items.push_back(std::move(reducedValueExpression));
@@ -620,8 +1026,10 @@ namespace wiz {
                         if (const auto resultType = findCompatibleConcatenationExpressionType(left.get(), right.get())) {
                             bool isLeftArray = left->variant.is<Expression::ArrayLiteral>();
                             bool isLeftString = left->variant.is<Expression::StringLiteral>();
+                            bool isLeftPacked = left->variant.is<Expression::PackedArrayLiteral>();
                             bool isRightArray = right->variant.is<Expression::ArrayLiteral>();
                             bool isRightString = right->variant.is<Expression::StringLiteral>();
+                            bool isRightPacked = right->variant.is<Expression::PackedArrayLiteral>();
 
                             // NOTE: Assumes if compatible type was found, it must be [u8], because string literals are [u8]. Hopefully this is always true!
                             if (isLeftString && isRightArray) {
@@ -664,6 +1072,36 @@ namespace wiz {
                                     + right->variant.get<Expression::StringLiteral>().value.toString());
 
                                 return createStringLiteralExpression(result, expression->location);
+                            } else if ((isLeftPacked || isLeftString) && (isRightPacked || isRightString)) {
+                                // The element types are equivalent, so the buffers can be joined as they are.
+                                const auto leftData = isLeftPacked ? left->variant.get<Expression::PackedArrayLiteral>().data : left->variant.get<Expression::StringLiteral>().value;
+                                const auto rightData = isRightPacked ? right->variant.get<Expression::PackedArrayLiteral>().data : right->variant.get<Expression::StringLiteral>().value;
+
+                                if (isLeftString || isRightString) {
+                                    return createStringLiteralExpression(stringPool->intern(leftData.toString() + rightData.toString()), expression->location);
+                                }
+
+                                std::vector<std::uint8_t> result;
+                                result.reserve(leftData.getLength() + rightData.getLength());
+                                result.insert(result.end(), leftData.getData(), leftData.getData() + leftData.getLength());
+                                result.insert(result.end(), rightData.getData(), rightData.getData() + rightData.getLength());
+                                return createPackedArrayLiteralExpression(std::move(result), left->variant.get<Expression::PackedArrayLiteral>().elementType, expression->location);
+                            } else if ((isLeftArray && isRightPacked) || (isLeftPacked && isRightArray)) {
+                                const auto leftLength = tryGetSequenceLiteralLength(left.get());
+                                const auto rightLength = tryGetSequenceLiteralLength(right.get());
+                                const auto elementType = resultType->variant.get<TypeExpression::Array>().elementType.get();
+
+                                std::vector<FwdUniquePtr<const Expression>> reducedItems;
+                                reducedItems.reserve(*leftLength + *rightLength);
+
+                                for (std::size_t i = 0; i != *leftLength; ++i) {
+                                    reducedItems.push_back(createConvertedExpression(getSequenceLiteralItem(left.get(), i).get(), elementType));
+                                }
+                                for (std::size_t i = 0; i != *rightLength; ++i) {
+                                    reducedItems.push_back(createConvertedExpression(getSequenceLiteralItem(right.get(), i).get(), elementType));
+                                }
+
+                                return createArrayLiteralExpression(std::move(reducedItems), elementType, expression->location);
                             } else if (isLeftArray && isRightArray) {
                                 const auto& leftItems = left->variant.get<Expression::ArrayLiteral>().items;
                                 const auto& rightItems = right->variant.get<Expression::ArrayLiteral>().items;
@@ -738,6 +1176,23 @@ namespace wiz {
                                             ExpressionInfo(EvaluationContext::CompileTime,
                                                 makeFwdUnique<const TypeExpression>(TypeExpression::ResolvedIdentifier(builtins.getDefinition(Builtins::DefinitionType::IExpr)), expression->location),
                                                 Qualifiers {}));
+                                    } else if (const auto packedArrayLiteral = left->variant.tryGet<Expression::PackedArrayLiteral>()) {
+                                        const auto length = tryGetSequenceLiteralLength(left.get());
+
+                                        if (indexValue.isNegative()) {
+                                            report->error("indexing by negative integer `" + indexValue.toString() + "`", expression->location);
+                                            return nullptr;
+                                        }
+                                        if (indexValue >= Int128(*length)) {
+                                            report->error("indexing by `" + indexValue.toString() + "` exceeds array length of `" + std::to_string(*length) + "`", expression->location);
+                                            return nullptr;
+                                        }
+
+                                        std::size_t index = static_cast<std::size_t>(indexValue);
+                                        return makeFwdUnique<const Expression>(Expression::IntegerLiteral(getPackedArrayLiteralValue(left.get(), index)), expression->location,
+                                            ExpressionInfo(EvaluationContext::CompileTime,
+                                                makeFwdUnique<const TypeExpression>(TypeExpression::ResolvedIdentifier(packedArrayLiteral->elementType), expression->location),
+                                                Qualifiers {}));
                                     } else if (const auto resolvedIdentifier = left->variant.tryGet<Expression::ResolvedIdentifier>()) {
                                         if (const auto varDefinition = resolvedIdentifier->definition->variant.tryGet<Definition::Var>()) {
                                             if (varDefinition->address.hasValue() && varDefinition->address->absolutePosition.hasValue()) {
@@ -1005,26 +1460,76 @@ namespace wiz {
                                 return nullptr;
                             }
                         } else {
-                            // Create a temporary scope with a bunch of temporary let declarations representing the arguments.
-                            // This scope will be cleaned up at the end of this function.
-                            auto scope = std::make_unique<SymbolTable>(definition->parentScope, StringView());
+                            const auto letCacheable = isLetCacheable(definition);
+                            const auto cacheable = letCacheable
+                                && std::all_of(reducedArguments.begin(), reducedArguments.end(),
+                                    [&](const FwdUniquePtr<const Expression>& argument) { return isCacheableLetArgument(argument.get()); });
+
+                            if (cacheable) {
+                                for (const auto& cachedCall : letDefinition->cachedCalls) {
+                                    bool match = true;
+                                    for (std::size_t i = 0; i != parameters.size() && match; ++i) {
+                                        match = isSameLetArgument(cachedCall.arguments[i].get(), reducedArguments[i].get());
+                                    }
+                                    if (match) {
+                                        ++letCacheHits;
+                                        return cachedCall.result->clone();
+                                    }
+                                }
+                                ++letCacheMisses;
+                            }
 
-                            std::vector<FwdUniquePtr<const Statement>> argumentBindings;
-                            argumentBindings.reserve(parameters.size());
+                            if (const auto program = letDefinition->program.get()) {
+                                bool validArguments = true;
+                                for (std::size_t i = 0; i != parameters.size() && validArguments; ++i) {
+                                    ExpressionProgram::Value argument;
+                                    validArguments = tryGetExpressionProgramValue(reducedArguments[i].get(), argument);
+                                    program->setInput(i, argument);
+                                }
+                                if (validArguments) {
+                                    result = evaluateExpressionProgram(*program);
+                                }
+                            }
 
-                            for (std::size_t i = 0; i != parameters.size(); ++i) {
-                                if (scope->createDefinition(report, Definition::Let({}, reducedArguments[i].get()), parameters[i], definition->declaration) == nullptr) {
-                                    return nullptr;
+                            if (result == nullptr) {
+                                // Create a temporary scope with a bunch of temporary let declarations representing the arguments.
+                                // This scope will be cleaned up at the end of this function.
+                                auto scope = std::make_unique<SymbolTable>(definition->parentScope, StringView());
+
+                                std::vector<FwdUniquePtr<const Statement>> argumentBindings;
+                                argumentBindings.reserve(parameters.size());
+
+                                for (std::size_t i = 0; i != parameters.size(); ++i) {
+                                    if (scope->createDefinition(report, Definition::Let({}, reducedArguments[i].get()), parameters[i], definition->declaration) == nullptr) {
+                                        return nullptr;
+                                    }
+                                }
+
+                                // Use temporary scope to evaluate let function, and return the result.
+                                enterScope(scope.get());
+                                if (enterLetExpression(definition->name, expression->location)) {                            
+                                    result = reduceExpression(letDefinition->expression);
+                                    exitLetExpression();
+                                }
+                                exitScope();
+
+                                // Later calls can use bytecode instead, now that the expression is known to reduce cleanly.
+                                if (letCacheable && result != nullptr && !letDefinition->programCompiled) {
+                                    letDefinition->programCompiled = true;
+
+                                    enterScope(definition->parentScope);
+                                    letDefinition->program = compileExpressionProgram(letDefinition->expression, parameters);
+                                    exitScope();
                                 }
                             }
 
-                            // Use temporary scope to evaluate let function, and return the result.
-                            enterScope(scope.get());
-                            if (enterLetExpression(definition->name, expression->location)) {                            
-                                result = reduceExpression(letDefinition->expression);
-                                exitLetExpression();
+                            // The result never refers to the arguments' own locations, since parameter references take the location of the reference.
+                            if (cacheable && result != nullptr
+                            && result->info->context == EvaluationContext::CompileTime
+                            && letDefinition->cachedCalls.size() < MaxCachedLetCalls) {
+                                auto cachedResult = result->clone();
+                                letDefinition->cachedCalls.push_back(Definition::Let::CachedCall(std::move(reducedArguments), std::move(cachedResult)));
                             }
-                            exitScope();
                         }
 
                         return result;
@@ -1233,7 +1738,14 @@ namespace wiz {
                 switch (result) {
                     case ImportResult::JustImported: {
                         if (reader && reader->isOpen()) {
-                            data = stringPool->intern(reader->readFully());
+                            // Mapped files are referenced in place, so the reader is kept open for as long as the compiler.
+                            StringView view;
+                            if (reader->viewFully(view)) {
+                                data = view;
+                                embedReaders.push_back(std::move(reader));
+                            } else {
+                                data = stringPool->intern(reader->readFully());
+                            }
                             embedCache[canonicalPath] = *data;
                         }
                         break;
@@ -1385,6 +1897,10 @@ namespace wiz {
 
                 return nullptr;                
             }
+            case Expression::VariantType::typeIndexOf<Expression::PackedArrayLiteral>(): {
+                // Only ever created already reduced.
+                return expression->clone();
+            }
             case Expression::VariantType::typeIndexOf<Expression::RangeLiteral>(): {
                 const auto& rangeLiteral = variant.get<Expression::RangeLiteral>();
                 auto reducedStart = reduceExpression(rangeLiteral.start.get());
@@ -1998,6 +2514,8 @@ namespace wiz {
             return arrayLiteral->items.size();
         } else if (const auto stringLiteral = expression->variant.tryGet<Expression::StringLiteral>()) {
             return stringLiteral->value.getLength();
+        } else if (const auto packedArrayLiteral = expression->variant.tryGet<Expression::PackedArrayLiteral>()) {
+            return packedArrayLiteral->data.getLength() / packedArrayLiteral->elementType->variant.get<Definition::BuiltinIntegerType>().size;
         } else if (const auto rangeLiteral = expression->variant.tryGet<Expression::RangeLiteral>()) {
             const auto rangeStartLiteral = rangeLiteral->start->variant.tryGet<Expression::IntegerLiteral>();
             const auto rangeEndLiteral = rangeLiteral->end->variant.tryGet<Expression::IntegerLiteral>();
@@ -2025,7 +2543,7 @@ namespace wiz {
         return Optional<std::size_t>();
     }
 
-    FwdUniquePtr<const Expression> Compiler::getSequenceLiteralItem(const Expression* expression, std::size_t index) const {
+    FwdUniquePtr<const Expression> Compiler::getSequenceLiteralItem(const Expression* expression, std::size_t index) {
         if (const auto arrayLiteral = expression->variant.tryGet<Expression::ArrayLiteral>()) {
             return arrayLiteral->items[index]->clone();
         } else if (const auto stringLiteral = expression->variant.tryGet<Expression::StringLiteral>()) {
@@ -2033,6 +2551,11 @@ namespace wiz {
                 ExpressionInfo(EvaluationContext::CompileTime,
                     makeFwdUnique<const TypeExpression>(TypeExpression::ResolvedIdentifier(builtins.getDefinition(Builtins::DefinitionType::IExpr)), expression->location),
                     Qualifiers {}));
+        } else if (const auto packedArrayLiteral = expression->variant.tryGet<Expression::PackedArrayLiteral>()) {
+            // Items all share the location of the array, so repeated values unpack to the same shared node.
+            auto type = typeTable.intern(makeFwdUnique<const TypeExpression>(TypeExpression::ResolvedIdentifier(packedArrayLiteral->elementType), expression->location));
+            return expressionCache.intern(makeFwdUnique<const Expression>(Expression::IntegerLiteral(getPackedArrayLiteralValue(expression, index)), expression->location,
+                ExpressionInfo(EvaluationContext::CompileTime, std::move(type), Qualifiers {})));
         } else if (const auto rangeLiteral = expression->variant.tryGet<Expression::RangeLiteral>()) {
             const auto rangeStartLiteral = rangeLiteral->start->variant.tryGet<Expression::IntegerLiteral>();
             const auto rangeEndLiteral = rangeLiteral->end->variant.tryGet<Expression::IntegerLiteral>();
@@ -2071,6 +2594,10 @@ namespace wiz {
     }
 
     FwdUniquePtr<const Expression> Compiler::createArrayLiteralExpression(std::vector<FwdUniquePtr<const Expression>> items, const TypeExpression* elementType, SourceLocation location) const {
+        if (auto packed = tryCreatePackedArrayLiteralExpression(items, elementType, location)) {
+            return packed;
+        }
+
         const auto size = items.size();
 
         auto context = EvaluationContext::CompileTime;
@@ -2092,6 +2619,84 @@ namespace wiz {
                 Qualifiers {}));
     }
 
+    FwdUniquePtr<const Expression> Compiler::createPackedArrayLiteralExpression(std::vector<std::uint8_t> data, Definition* elementType, SourceLocation location) const {
+        const auto size = data.size() / elementType->variant.get<Definition::BuiltinIntegerType>().size;
+
+        return makeFwdUnique<const Expression>(Expression::PackedArrayLiteral(std::make_shared<const std::vector<std::uint8_t>>(std::move(data)), elementType), location,
+            ExpressionInfo(EvaluationContext::CompileTime,
+                makeFwdUnique<const TypeExpression>(TypeExpression::Array(
+                        makeFwdUnique<const TypeExpression>(TypeExpression::ResolvedIdentifier(elementType), location),
+                        makeFwdUnique<const Expression>(Expression::IntegerLiteral(Int128(size)), location,
+                            ExpressionInfo(EvaluationContext::CompileTime,
+                                makeFwdUnique<const TypeExpression>(TypeExpression::ResolvedIdentifier(builtins.getDefinition(Builtins::DefinitionType::IExpr)), location),
+                                Qualifiers {}))),
+                    location),
+                Qualifiers {}));
+    }
+
+    FwdUniquePtr<const Expression> Compiler::tryCreatePackedArrayLiteralExpression(const std::vector<FwdUniquePtr<const Expression>>& items, const TypeExpression* elementType, SourceLocation location) const {
+        // Every item must be a compile-time integer that fits the element type. Anything else stays an ArrayLiteral.
+        const auto packedElementType = tryGetPackedElementType(elementType);
+        if (packedElementType == nullptr) {
+            return nullptr;
+        }
+
+        const auto& builtinIntegerType = packedElementType->variant.get<Definition::BuiltinIntegerType>();
+        std::vector<std::uint8_t> data;
+        data.reserve(items.size() * builtinIntegerType.size);
+
+        for (const auto& item : items) {
+            const auto integerLiteral = item->variant.tryGet<Expression::IntegerLiteral>();
+            if (integerLiteral == nullptr
+            || item->info->context != EvaluationContext::CompileTime
+            || item->info->qualifiers != Qualifiers {}
+            || integerLiteral->value < builtinIntegerType.min
+            || integerLiteral->value > builtinIntegerType.max) {
+                return nullptr;
+            }
+
+            const auto itemTypeDefinition = tryGetResolvedIdentifierTypeDefinition(item->info->type.get());
+            if (itemTypeDefinition != packedElementType
+            && (itemTypeDefinition == nullptr || !itemTypeDefinition->variant.is<Definition::BuiltinIntegerExpressionType>())) {
+                return nullptr;
+            }
+
+            serializeInteger(integerLiteral->value, builtinIntegerType.size, data);
+        }
+
+        return createPackedArrayLiteralExpression(std::move(data), packedElementType, location);
+    }
+
+    Definition* Compiler::tryGetPackedElementType(const TypeExpression* elementType) const {
+        if (const auto definition = tryGetResolvedIdentifierTypeDefinition(elementType)) {
+            if (const auto builtinIntegerType = definition->variant.tryGet<Definition::BuiltinIntegerType>()) {
+                if (builtinIntegerType->size >= 1 && builtinIntegerType->size <= 4) {
+                    return definition;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    Int128 Compiler::getPackedArrayLiteralValue(const Expression* expression, std::size_t index) const {
+        const auto& packedArrayLiteral = expression->variant.get<Expression::PackedArrayLiteral>();
+        const auto& builtinIntegerType = packedArrayLiteral.elementType->variant.get<Definition::BuiltinIntegerType>();
+        const auto size = builtinIntegerType.size;
+        const auto data = reinterpret_cast<const std::uint8_t*>(packedArrayLiteral.data.getData()) + index * size;
+
+        std::uint32_t bits = 0;
+        for (std::size_t i = 0; i != size; ++i) {
+            bits |= static_cast<std::uint32_t>(data[i]) << (8U * i);
+        }
+
+        // Signed types were stored as two's complement.
+        auto value = Int128(bits);
+        if (value > builtinIntegerType.max) {
+            value -= Int128(UINT64_C(1) << (8U * size), 0);
+        }
+        return value;
+    }
+
     std::string Compiler::getResolvedIdentifierName(Definition* definition, const std::vector<StringView>& pieces) const {
         if (pieces.size() > 0) {
             return text::join(pieces.begin(), pieces.end(), ".");
@@ -2103,6 +2708,15 @@ namespace wiz {
     FwdUniquePtr<const Expression> Compiler::resolveDefinitionExpression(Definition* definition, const std::vector<StringView>& pieces, SourceLocation location) {
         if (const auto letDefinition = definition->variant.tryGet<Definition::Let>()) {
             if (letDefinition->parameters.size() == 0) {
+                const auto cacheable = isLetCacheable(definition);
+                if (cacheable) {
+                    if (const auto cachedResult = letDefinition->reducedExpression.get()) {
+                        ++letCacheHits;
+                        return cachedResult->clone(location, ExpressionInfo(cachedResult->info->context, cachedResult->info->type->clone(), cachedResult->info->qualifiers));
+                    }
+                    ++letCacheMisses;
+                }
+
                 FwdUniquePtr<const Expression> result;
 
                 enterScope(definition->parentScope);
@@ -2112,9 +2726,18 @@ namespace wiz {
                 }
                 exitScope();
 
-                return result != nullptr
-                    ? result->clone(location, ExpressionInfo(result->info->context, result->info->type->clone(), result->info->qualifiers))
-                    : nullptr;
+                if (result == nullptr) {
+                    return nullptr;
+                }
+
+                auto resolvedResult = result->clone(location, ExpressionInfo(result->info->context, result->info->type->clone(), result->info->qualifiers));
+
+                // Link-time results can still become compile-time ones once addresses are known, so only keep compile-time results.
+                if (cacheable && result->info->context == EvaluationContext::CompileTime) {
+                    letDefinition->reducedExpression = std::move(result);
+                }
+
+                return resolvedResult;
             } else {
                 return makeFwdUnique<const Expression>(Expression::ResolvedIdentifier(definition, pieces), location,
                     ExpressionInfo(EvaluationContext::CompileTime,
@@ -2782,7 +3405,7 @@ namespace wiz {
                     }
                 }
 
-                if (const auto rightArray = left->variant.tryGet<Expression::ArrayLiteral>()) {
+                if (const auto rightArray = right->variant.tryGet<Expression::ArrayLiteral>()) {
                     bool success = true;
                     for (const auto& item : rightArray->items) {
                         if (!canNarrowExpression(item.get(), leftElementType)) {
@@ -2931,6 +3554,10 @@ namespace wiz {
                 }
 
                 if (const auto sourceArray = sourceExpression->variant.tryGet<Expression::ArrayLiteral>()) {
+                    if (auto packed = tryCreatePackedArrayLiteralExpression(sourceArray->items, destinationElementType, sourceExpression->location)) {
+                        return packed;
+                    }
+
                     std::vector<FwdUniquePtr<const Expression>> convertedItems;
                     convertedItems.reserve(sourceArray->items.size());
 
@@ -3004,6 +3631,11 @@ namespace wiz {
             return false;
         }
 
+        // Structurally identical types are always equivalent. The reverse doesn't hold, since designated storage and unsized arrays are looser.
+        if (leftTypeExpression->canonical != nullptr && leftTypeExpression->canonical == rightTypeExpression->canonical) {
+            return true;
+        }
+
         if (const auto rightDesignatedStorageType = rightTypeExpression->variant.tryGet<TypeExpression::DesignatedStorage>()) {
             const auto leftSize = calculateStorageSize(leftTypeExpression, ""_sv);
             const auto rightSize = calculateStorageSize(rightDesignatedStorageType->elementType.get(), ""_sv);
@@ -3101,6 +3733,19 @@ namespace wiz {
             return "<unknown type>";
         }
 
+        if (const auto canonical = typeExpression->canonical) {
+            if (!canonical->hasName) {
+                canonical->name = getUncachedTypeName(typeExpression);
+                canonical->hasName = true;
+            }
+            return canonical->name;
+        }
+
+        return getUncachedTypeName(typeExpression);
+    }
+
+    std::string Compiler::getUncachedTypeName(const TypeExpression* typeExpression) const {
+
         const auto& variant = typeExpression->variant;
         switch (variant.index()) {
             case TypeExpression::VariantType::typeIndexOf<TypeExpression::Array>(): {
@@ -3182,6 +3827,18 @@ namespace wiz {
             return Optional<std::size_t>();
         }
 
+        if (const auto canonical = typeExpression->canonical) {
+            if (!canonical->storageSize.hasValue()) {
+                canonical->storageSize = calculateUncachedStorageSize(typeExpression, description);
+            }
+            return canonical->storageSize;
+        }
+
+        return calculateUncachedStorageSize(typeExpression, description);
+    }
+
+    Optional<std::size_t> Compiler::calculateUncachedStorageSize(const TypeExpression* typeExpression, StringView description) const {
+
         const auto& variant = typeExpression->variant;
         switch (variant.index()) {
             case TypeExpression::VariantType::typeIndexOf<TypeExpression::Array>(): {
@@ -3273,6 +3930,9 @@ namespace wiz {
     }
 
     Optional<std::size_t> Compiler::resolveExplicitAddressExpression(const Expression* expression) {
+        // Only the value is kept, so the reduced expression doesn't need to outlive this call.
+        Arena::TemporaryScope temporaryScope;
+
         if (expression != nullptr) {
             if (const auto reducedAddressExpression = reduceExpression(expression)) {
                 if (const auto addressLiteral = reducedAddressExpression->variant.tryGet<Expression::IntegerLiteral>()) {
@@ -3309,6 +3969,13 @@ namespace wiz {
                 x >>= 8; result.push_back(x & 0xFF);
                 return true;                            
             }
+            case 3: {
+                auto x = static_cast<std::uint32_t>(value);
+                result.push_back(x & 0xFF);
+                x >>= 8; result.push_back(x & 0xFF);
+                x >>= 8; result.push_back(x & 0xFF);
+                return true;
+            }
             case 4: {
                 auto x = static_cast<std::uint32_t>(value);
                 result.push_back(x & 0xFF);
@@ -3334,6 +4001,22 @@ namespace wiz {
     }
 
 
+    bool Compiler::tryGetConstantInitializerData(const Expression* expression, ArrayView<std::uint8_t>& result) const {
+        // Strings, embeds and packed arrays are already laid out the way serializeConstantInitializer would write them,
+        // so they can be copied into the bank straight from their buffer. For an embed, that is the file mapping.
+        StringView data;
+        if (const auto stringLiteral = expression->variant.tryGet<Expression::StringLiteral>()) {
+            data = stringLiteral->value;
+        } else if (const auto packedArrayLiteral = expression->variant.tryGet<Expression::PackedArrayLiteral>()) {
+            data = packedArrayLiteral->data;
+        } else {
+            return false;
+        }
+
+        result = ArrayView<std::uint8_t>(reinterpret_cast<const std::uint8_t*>(data.getData()), data.getLength());
+        return true;
+    }
+
     bool Compiler::serializeConstantInitializer(const Expression* expression, std::vector<std::uint8_t>& result) const {
         // NOTE: this requires a fully-reduced literal value expression.
         // All identifiers, operators, embeds, etc. must be substituted with a reduced literal values.
@@ -3369,6 +4052,13 @@ namespace wiz {
                 return false;
             }
             case Expression::VariantType::typeIndexOf<Expression::OffsetOf>(): std::abort(); return false;
+            case Expression::VariantType::typeIndexOf<Expression::PackedArrayLiteral>(): {
+                // Packed items were written by serializeInteger, so they can be copied as they are.
+                const auto& data = variant.get<Expression::PackedArrayLiteral>().data;
+                const auto bytes = reinterpret_cast<const std::uint8_t*>(data.getData());
+                result.insert(result.end(), bytes, bytes + data.getLength());
+                return true;
+            }
             case Expression::VariantType::typeIndexOf<Expression::RangeLiteral>(): return false;
             case Expression::VariantType::typeIndexOf<Expression::ResolvedIdentifier>(): {
                 const auto& resolvedIdentifier = variant.get<Expression::ResolvedIdentifier>();
@@ -3393,11 +4083,8 @@ namespace wiz {
             case Expression::VariantType::typeIndexOf<Expression::SideEffect>(): return false;
             case Expression::VariantType::typeIndexOf<Expression::StringLiteral>(): {
                 const auto& stringLiteral = variant.get<Expression::StringLiteral>();
-                const auto data = stringLiteral.value.getData();
-                const auto len = stringLiteral.value.getLength();
-                for (std::size_t i = 0; i != len; ++i) {
-                    result.push_back(data[i]);
-                }
+                const auto data = reinterpret_cast<const std::uint8_t*>(stringLiteral.value.getData());
+                result.insert(result.end(), data, data + stringLiteral.value.getLength());
                 return true;
             }
             case Expression::VariantType::typeIndexOf<Expression::StructLiteral>(): {
@@ -4531,6 +5218,7 @@ namespace wiz {
                 return makeFwdUnique<InstructionOperand>(InstructionOperand::Integer(integerLiteral.value));
             }
             case Expression::VariantType::typeIndexOf<Expression::OffsetOf>(): return nullptr;
+            case Expression::VariantType::typeIndexOf<Expression::PackedArrayLiteral>(): return nullptr;
             case Expression::VariantType::typeIndexOf<Expression::RangeLiteral>(): return nullptr;
             case Expression::VariantType::typeIndexOf<Expression::ResolvedIdentifier>(): {
                 const auto& resolvedIdentifier = variant.get<Expression::ResolvedIdentifier>();
@@ -4628,6 +5316,7 @@ namespace wiz {
                 case Expression::VariantType::typeIndexOf<Expression::Identifier>(): return true;
                 case Expression::VariantType::typeIndexOf<Expression::IntegerLiteral>(): return true;
                 case Expression::VariantType::typeIndexOf<Expression::OffsetOf>(): return true;
+                case Expression::VariantType::typeIndexOf<Expression::PackedArrayLiteral>(): return true;
                 case Expression::VariantType::typeIndexOf<Expression::RangeLiteral>(): return true;
                 case Expression::VariantType::typeIndexOf<Expression::ResolvedIdentifier>(): return true;
                 case Expression::VariantType::typeIndexOf<Expression::SideEffect>(): return false;
@@ -4668,7 +5357,7 @@ namespace wiz {
         operandRoots.push_back(InstructionOperandRoot(source, std::move(sourceOperand)));
 
         if (const auto instruction = builtins.selectInstruction(InstructionType(BinaryOperatorKind::Assignment), modeFlags, operandRoots)) {
-            irNodes.addNew(IrNode::Code(instruction, std::move(operandRoots)), location);
+            irNodes.addCode(instruction, modeFlags, std::move(operandRoots), location);
             return true;
         } else {
             return false;
@@ -4697,7 +5386,7 @@ namespace wiz {
         }            
 
         if (const auto instruction = builtins.selectInstruction(InstructionType(op), modeFlags, operandRoots)) {
-            irNodes.addNew(IrNode::Code(instruction, std::move(operandRoots)), location);
+            irNodes.addCode(instruction, modeFlags, std::move(operandRoots), location);
             return true;
         } else {
             return false;
@@ -4729,9 +5418,7 @@ namespace wiz {
         }
 
         if (const auto instruction = builtins.selectInstruction(InstructionType(op), modeFlags, operandRoots)) {
-            irNodes.addNew(
-                IrNode::Code(instruction, std::move(operandRoots)),
-                location);
+            irNodes.addCode(instruction, modeFlags, std::move(operandRoots), location);
             return true;
         } else {
             return false;
@@ -4824,7 +5511,7 @@ namespace wiz {
                     }
 
                     if (const auto instruction = builtins.selectInstruction(InstructionType(kind), modeFlags, operandRoots)) {
-                        irNodes.addNew(IrNode::Code(instruction, std::move(operandRoots)), function->location);
+                        irNodes.addCode(instruction, modeFlags, std::move(operandRoots), function->location);
                     } else {
                         return false;
                     }
@@ -4890,7 +5577,7 @@ namespace wiz {
                     modeFlags,
                     operandRoots)
                 ) {
-                    irNodes.addNew(IrNode::Code(instruction, std::move(operandRoots)), function->location);
+                    irNodes.addCode(instruction, modeFlags, std::move(operandRoots), function->location);
                     return true;
                 } else {
                     raiseEmitIntrinsicError(InstructionType(InstructionType::VoidIntrinsic(definition)), operandRoots, location);
@@ -4948,7 +5635,7 @@ namespace wiz {
                     modeFlags,
                     operandRoots)
                 ) {
-                    irNodes.addNew(IrNode::Code(instruction, std::move(operandRoots)), location);
+                    irNodes.addCode(instruction, modeFlags, std::move(operandRoots), location);
                     return true;
                 } else {
                     raiseEmitIntrinsicError(InstructionType(InstructionType::LoadIntrinsic(definition)), operandRoots, location);
@@ -4981,7 +5668,7 @@ namespace wiz {
             }
 
             if (const auto instruction = builtins.selectInstruction(InstructionType(kind), modeFlags, operandRoots)) {
-                irNodes.addNew(IrNode::Code(instruction, std::move(operandRoots)), function->location);
+                irNodes.addCode(instruction, modeFlags, std::move(operandRoots), function->location);
 
                 if (resultDestination != nullptr) {
                     const auto returnType = functionType->returnType.get();
@@ -5200,7 +5887,7 @@ namespace wiz {
         report->error("expression must be rewritten some other way\n", right->location);
     }
 
-    void Compiler::raiseEmitIntrinsicError(const InstructionType& instructionType, const std::vector<InstructionOperandRoot>& operandRoots, SourceLocation location) {
+    void Compiler::raiseEmitIntrinsicError(const InstructionType& instructionType, ArrayView<InstructionOperandRoot> operandRoots, SourceLocation location) {
         std::string intrinsicName;
         bool isLoadIntrinsic = false;
         if (const auto voidIntrinsic = instructionType.variant.tryGet<InstructionType::VoidIntrinsic>()) {
@@ -5494,7 +6181,7 @@ namespace wiz {
                             && emitBranchIr(distanceHint, returnKind, nullptr, nullptr, false, nullptr, location);
 
                         currentFunction = oldFunction;
-                        irNodes.addNew(IrNode::Label(failureLabelDefinition), location);
+                        irNodes.addLabel(failureLabelDefinition, location);
                         return result;
                     }
 
@@ -5591,7 +6278,7 @@ namespace wiz {
                             }
 
                             if (const auto instruction = builtins.selectInstruction(testAndBranch->testInstructionType, modeFlags, operandRoots)) {
-                                irNodes.addNew(IrNode::Code(instruction, std::move(operandRoots)), location);
+                                irNodes.addCode(instruction, modeFlags, std::move(operandRoots), location);
                                 return true;
                             }
                         }
@@ -5599,7 +6286,7 @@ namespace wiz {
                         return false;
                     } else {
                         if (const auto testInstruction = builtins.selectInstruction(testAndBranch->testInstructionType, modeFlags, operandRoots)) {
-                            irNodes.addNew(IrNode::Code(testInstruction, std::move(operandRoots)), location);
+                            irNodes.addCode(testInstruction, modeFlags, std::move(operandRoots), location);
                         } else {
                             return false;
                         }
@@ -5615,7 +6302,7 @@ namespace wiz {
                             }
                         }
 
-                        irNodes.addNew(IrNode::Label(failureLabelDefinition), location);
+                        irNodes.addLabel(failureLabelDefinition, location);
                         return true;
                     }
                 }
@@ -5631,7 +6318,7 @@ namespace wiz {
                                 return false;
                             }
 
-                            irNodes.addNew(IrNode::Label(failureLabelDefinition), location);
+                            irNodes.addLabel(failureLabelDefinition, location);
                             return true;
                         } else {
                             return emitBranchIr(distanceHint, kind, destination, returnValue, !negated, binaryOperator->left.get(), condition->location)
@@ -5651,7 +6338,7 @@ namespace wiz {
                                 return false;
                             }
 
-                            irNodes.addNew(IrNode::Label(failureLabelDefinition), location);
+                            irNodes.addLabel(failureLabelDefinition, location);
                             return true;
                         }
                     }
@@ -5689,7 +6376,7 @@ namespace wiz {
                     operandRoots.push_back(InstructionOperandRoot(nullptr, makeFwdUnique<InstructionOperand>(InstructionOperand::Boolean(!negated))));                    
 
                     if (const auto instruction = builtins.selectInstruction(InstructionType(kind), modeFlags, operandRoots)) {
-                        irNodes.addNew(IrNode::Code(instruction, std::move(operandRoots)), location);
+                        irNodes.addCode(instruction, modeFlags, std::move(operandRoots), location);
                         return true;
                     } else {
                         return false;
@@ -5726,7 +6413,7 @@ namespace wiz {
             }
 
             if (const auto instruction = builtins.selectInstruction(InstructionType(kind), modeFlags, operandRoots)) {
-                irNodes.addNew(IrNode::Code(instruction, std::move(operandRoots)), location);
+                irNodes.addCode(instruction, modeFlags, std::move(operandRoots), location);
                 return true;
             } else {
                 return false;
@@ -5782,7 +6469,7 @@ namespace wiz {
         }
 
         if (!funcDefinition.inlined) {
-            irNodes.addNew(IrNode::Label(currentFunction), location);
+            irNodes.addLabel(currentFunction, location);
         }
 
         funcDefinition.hasUnconditionalReturn = funcDefinition.hasUnconditionalReturn || hasUnconditionalReturn(funcDefinition.body);
@@ -5806,7 +6493,7 @@ namespace wiz {
         }
 
         if (returnLabel != nullptr) {
-            irNodes.addNew(IrNode::Label(returnLabel), location);
+            irNodes.addLabel(returnLabel, location);
         }
 
         return true;
@@ -5869,13 +6556,13 @@ namespace wiz {
                 continueLabel = beginLabelDefinition;
                 breakLabel = endLabelDefinition;
 
-                irNodes.addNew(IrNode::Label(beginLabelDefinition), statement->location);
+                irNodes.addLabel(beginLabelDefinition, statement->location);
                 emitStatementIr(doWhileStatement.body.get());
                 if (!emitBranchIr(doWhileStatement.distanceHint, BranchKind::Goto, beginLabelReferenceExpression, nullptr, false, reducedCondition, reducedCondition->location)) {
                     report->error("could not generate branch instruction for " + statement->getDescription().toString(), statement->location);
                     break;
                 }
-                irNodes.addNew(IrNode::Label(endLabelDefinition), reducedCondition->location);
+                irNodes.addLabel(endLabelDefinition, reducedCondition->location);
                 break;
             }
             case Statement::VariantType::typeIndexOf<Statement::Enum>(): break;
@@ -6042,14 +6729,14 @@ namespace wiz {
                     report->error("could not generate initial assignment instruction for " + statement->getDescription().toString(), statement->location);
                     break;
                 }
-                irNodes.addNew(IrNode::Label(beginLabelDefinition), statement->location);
+                irNodes.addLabel(beginLabelDefinition, statement->location);
                 emitStatementIr(forStatement.body.get());
-                irNodes.addNew(IrNode::Code(incrementInstruction, std::move(incrementOperandRoots)), reducedCondition->location);
+                irNodes.addCode(incrementInstruction, modeFlags, std::move(incrementOperandRoots), reducedCondition->location);
                 if (!emitBranchIr(forStatement.distanceHint, BranchKind::Goto, beginLabelReferenceExpression, nullptr, conditionNegated, reducedCondition, reducedCondition->location)) {
                     report->error("could not generate branch instruction for " + statement->getDescription().toString(), statement->location);
                     break;
                 }
-                irNodes.addNew(IrNode::Label(endLabelDefinition), reducedCondition->location);
+                irNodes.addLabel(endLabelDefinition, reducedCondition->location);
                 break;
             }
             case Statement::VariantType::typeIndexOf<Statement::Func>(): {
@@ -6105,12 +6792,12 @@ namespace wiz {
                         report->error("could not generate branch instruction for " + statement->getDescription().toString(), statement->location);
                         break;
                     }
-                    irNodes.addNew(IrNode::Label(elseLabelDefinition), statement->location);
+                    irNodes.addLabel(elseLabelDefinition, statement->location);
                     emitStatementIr(ifStatement.alternative.get());
                 } else {
-                    irNodes.addNew(IrNode::Label(elseLabelDefinition), statement->location);
+                    irNodes.addLabel(elseLabelDefinition, statement->location);
                 }
-                irNodes.addNew(IrNode::Label(endLabelDefinition), statement->location);
+                irNodes.addLabel(endLabelDefinition, statement->location);
                 break;
             }
             case Statement::VariantType::typeIndexOf<Statement::In>(): {
@@ -6119,9 +6806,9 @@ namespace wiz {
 
                 const auto result = handleInStatement(inStatement.pieces, inStatement.dest.get(), statement->location);
                 if (result.first) {
-                    irNodes.addNew(IrNode::PushRelocation(currentBank, result.second), statement->location);
+                    irNodes.addPushRelocation(currentBank, result.second, statement->location);
                     emitStatementIr(inStatement.body.get());
-                    irNodes.addNew(IrNode::PopRelocation(), statement->location);
+                    irNodes.addPopRelocation(statement->location);
                 }
 
                 currentBank = bankStack.back();
@@ -6161,7 +6848,7 @@ namespace wiz {
                 continueLabel = beginLabelDefinition;
                 breakLabel = endLabelDefinition;
 
-                irNodes.addNew(IrNode::Label(beginLabelDefinition), statement->location);
+                irNodes.addLabel(beginLabelDefinition, statement->location);
 
                 for (std::size_t i = 0; i != *length; ++i) {
                     enterInlineSite(registeredInlineSites.addNew());
@@ -6190,7 +6877,7 @@ namespace wiz {
                     }
                 }
 
-                irNodes.addNew(IrNode::Label(endLabelDefinition), statement->location);
+                irNodes.addLabel(endLabelDefinition, statement->location);
 
                 exitScope();
                 break;
@@ -6240,7 +6927,7 @@ namespace wiz {
                     break;
                 }
 
-                irNodes.addNew(IrNode::Label(currentScope->findLocalMemberDefinition(labelDeclaration.name)), statement->location);
+                irNodes.addLabel(currentScope->findLocalMemberDefinition(labelDeclaration.name), statement->location);
                 break;
             }
             case Statement::VariantType::typeIndexOf<Statement::Let>(): break;
@@ -6265,10 +6952,10 @@ namespace wiz {
                     }
 
                     if (!varDefinition.qualifiers.has<Qualifier::Extern>() && varDefinition.enclosingFunction == nullptr && currentBank != nullptr && isBankKindStored(currentBank->getKind())) {
-                        irNodes.addNew(IrNode::Var(definition), statement->location);
+                        irNodes.addVar(definition, statement->location);
 
                         for (auto& nestedConstant : varDefinition.nestedConstants) {
-                            irNodes.addNew(IrNode::Var(nestedConstant), statement->location);
+                            irNodes.addVar(nestedConstant, statement->location);
                         }
                     }
                 }
@@ -6302,7 +6989,7 @@ namespace wiz {
                 continueLabel = beginLabelDefinition;
                 breakLabel = endLabelDefinition;
 
-                irNodes.addNew(IrNode::Label(beginLabelDefinition), statement->location);
+                irNodes.addLabel(beginLabelDefinition, statement->location);
                 if (!emitBranchIr(whileStatement.distanceHint, BranchKind::Goto, endLabelReferenceExpression, nullptr, true, reducedCondition, statement->location)) {
                     break;
                 }
@@ -6310,7 +6997,7 @@ namespace wiz {
                 if (!emitBranchIr(whileStatement.distanceHint, BranchKind::Goto, beginLabelReferenceExpression, nullptr, false, nullptr, statement->location)) {
                     break;
                 }
-                irNodes.addNew(IrNode::Label(endLabelDefinition), statement->location);
+                irNodes.addLabel(endLabelDefinition, statement->location);
                 break;
             }
             default: std::abort(); return false;
@@ -6319,44 +7006,42 @@ namespace wiz {
         return statement == program.get() ? report->validate() : report->alive();
     }
 
-    bool Compiler::generateCode() {
+    bool Compiler::layoutCode(InstructionCaptureLists& captureLists, std::vector<std::size_t>& irNodesToRemove, std::vector<RelaxableBranch>& relaxableBranches) {
         for (auto& bank : registeredBanks) {
             bank->rewind();
         }
-        
-        std::vector<std::vector<const InstructionOperand*>> captureLists;
-        std::set<std::size_t> irNodeIndexesToRemove;
+
+        irNodesToRemove.clear();
+        relaxableBranches.clear();
 
         // First pass: calculate data/instruction sizes, assign labels.
         for (std::size_t i = 0; i != irNodes.size(); ++i) {
-            const auto& irNode = irNodes[i];
-            const auto& variant = irNode->variant;
-            switch (variant.index()) {
-                case IrNode::VariantType::typeIndexOf<IrNode::PushRelocation>(): {
-                    const auto& pushRelocation = variant.get<IrNode::PushRelocation>();
+            const auto& location = irNodes.getLocation(i);
+            switch (irNodes.getKind(i)) {
+                case IrNodeKind::PushRelocation: {
+                    const auto& pushRelocation = irNodes.getRelocation(i);
                     bankStack.push_back(currentBank);
                     currentBank = pushRelocation.bank;
 
                     if (const auto address = pushRelocation.address.tryGet()) {
-                        currentBank->absoluteSeek(report, *address, irNode->location);
+                        currentBank->absoluteSeek(report, *address, location);
                     }
                     break;
                 }
-                case IrNode::VariantType::typeIndexOf<IrNode::PopRelocation>(): {
+                case IrNodeKind::PopRelocation: {
                     currentBank = bankStack.back();
                     bankStack.pop_back();
                     break;
                 }
-                case IrNode::VariantType::typeIndexOf<IrNode::Label>(): {
-                    const auto& label = variant.get<IrNode::Label>();
-                    auto& funcDefinition = label.definition->variant.get<Definition::Func>();
+                case IrNodeKind::Label: {
+                    auto& funcDefinition = irNodes.getDefinition(i)->variant.get<Definition::Func>();
                     funcDefinition.address = currentBank->getAddress();                    
                     break;
                 }
-                case IrNode::VariantType::typeIndexOf<IrNode::Code>(): {
-                    const auto& code = variant.get<IrNode::Code>();
-                    const auto& instruction = code.instruction;
-                    if (instruction->signature.extract(code.operandRoots, captureLists)) {
+                case IrNodeKind::Code: {
+                    const auto instruction = irNodes.getInstruction(i);
+                    const auto operandRoots = irNodes.getOperandRoots(i);
+                    if (instruction->signature.extract(operandRoots, captureLists)) {
                         bool removed = false;
 
                         // Slight optimization: remove redundant jump if the destination label is immediately after this.
@@ -6368,13 +7053,12 @@ namespace wiz {
                                 const auto& patterns = instruction->signature.operandPatterns;
 
                                 if (patterns.size() >= 2 && patterns[1]->variant.is<InstructionOperandPattern::IntegerRange>()) {
-                                    if (const auto resolvedIdentifier = code.operandRoots[1].expression->variant.tryGet<Expression::ResolvedIdentifier>()) {
+                                    if (const auto resolvedIdentifier = operandRoots[1].expression->variant.tryGet<Expression::ResolvedIdentifier>()) {
                                         std::size_t nextIndex = i + 1;
 
                                         while (nextIndex < irNodes.size()) {
-                                            const auto& nextIrNode = irNodes[nextIndex];
-                                            if (const auto nextLabel = nextIrNode->variant.tryGet<IrNode::Label>()) {
-                                                if (resolvedIdentifier->definition == nextLabel->definition) {
+                                            if (irNodes.getKind(nextIndex) == IrNodeKind::Label) {
+                                                if (resolvedIdentifier->definition == irNodes.getDefinition(nextIndex)) {
                                                     removed = true;
                                                     break;
                                                 }
@@ -6390,28 +7074,32 @@ namespace wiz {
                         }
 
                         if (removed) {
-                            irNodeIndexesToRemove.insert(i);
+                            irNodesToRemove.push_back(i);
                         } else {
+                            if (instruction->encoding->checkRange != nullptr && instruction->signature.type.variant.is<BranchKind>()) {
+                                relaxableBranches.push_back(RelaxableBranch(i, currentBank, currentBank->getRelativePosition()));
+                            }
+
                             const auto size = instruction->encoding->calculateSize(instruction->options, captureLists);
-                            currentBank->reserveRom(report, "code"_sv, irNode.get(), irNode->location, size);
+                            currentBank->reserveRom(report, "code"_sv, irNodes.getOwner(i), location, size);
                         }
                     } else {
-                        report->error("failed to extract instruction capture list during instruction selection pass", irNode->location, ReportErrorFlags::of<ReportErrorFlagType::InternalError>());
+                        report->error("failed to extract instruction capture list during instruction selection pass", location, ReportErrorFlags::of<ReportErrorFlagType::InternalError>());
                     }
                     break;
                 }
-                case IrNode::VariantType::typeIndexOf<IrNode::Var>(): {
-                    const auto& var = variant.get<IrNode::Var>();
-                    auto& varDefinition = var.definition->variant.get<Definition::Var>();
+                case IrNodeKind::Var: {
+                    const auto definition = irNodes.getDefinition(i);
+                    auto& varDefinition = definition->variant.get<Definition::Var>();
 
                     Optional<std::size_t> oldPosition;
                     if (varDefinition.addressExpression != nullptr) {
-                        enterScope(var.definition->parentScope);
+                        enterScope(definition->parentScope);
 
                         const auto address = resolveExplicitAddressExpression(varDefinition.addressExpression);
                         if (address.hasValue()) {
                             oldPosition = currentBank->getRelativePosition();
-                            currentBank->absoluteSeek(report, address.get(), irNode->location);
+                            currentBank->absoluteSeek(report, address.get(), location);
                         } else {
                             break;
                         }
@@ -6421,7 +7109,7 @@ namespace wiz {
  
                     varDefinition.address = currentBank->getAddress();
  
-                    if (!currentBank->reserveRom(report, "constant data"_sv, irNode.get(), irNode->location, varDefinition.storageSize.get())) {
+                    if (!currentBank->reserveRom(report, "constant data"_sv, irNodes.getOwner(i), location, varDefinition.storageSize.get())) {
                         break;
                     }
  
@@ -6434,162 +7122,388 @@ namespace wiz {
             }
         }
 
-        for (auto it = irNodeIndexesToRemove.rbegin(); it != irNodeIndexesToRemove.rend(); ++it) {
-            irNodes.remove(*it);
+        return report->validate();
+    }
+
+    bool Compiler::resolveLinkTimeOperands(ArrayView<InstructionOperandRoot> operandRoots, SourceLocation location, std::vector<const InstructionOperand*>& operands, std::vector<FwdUniquePtr<const InstructionOperand>>& resolvedOperands) {
+        operands.clear();
+        resolvedOperands.clear();
+
+        // Only operands that had placeholders for link-time values need to be resolved again, the rest are reused as-is.
+        for (const auto& operandRoot : operandRoots) {
+            if (!operandRoot.linkTimeDependent) {
+                operands.push_back(operandRoot.operand.get());
+            } else if (const auto reducedExpression = reduceExpression(operandRoot.expression)) {
+                if (auto operand = createOperandFromExpression(reducedExpression.get(), true)) {
+                    operands.push_back(operand.get());
+                    resolvedOperands.push_back(std::move(operand));
+                } else {
+                    report->error("failed to create operand for reduced expresion", location, ReportErrorFlags::of<ReportErrorFlagType::InternalError>());
+                    return false;
+                }
+            } else {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::size_t Compiler::relaxBranches(const std::vector<RelaxableBranch>& relaxableBranches, InstructionCaptureLists& captureLists, std::vector<const InstructionOperand*>& tempOperands, std::vector<FwdUniquePtr<const InstructionOperand>>& tempResolvedOperands) {
+        std::size_t promotedCount = 0;
+
+        for (const auto& branch : relaxableBranches) {
+            const auto instruction = irNodes.getInstruction(branch.index);
+            bool inRange = true;
+
+            // The resolved operands are only needed for the range check, so they can all be thrown away afterwards.
+            {
+                Arena::TemporaryScope temporaryScope;
+
+                // Problems resolving the operands are left to the final pass to report.
+                if (resolveLinkTimeOperands(irNodes.getOperandRoots(branch.index), irNodes.getLocation(branch.index), tempOperands, tempResolvedOperands)
+                && instruction->signature.extract(ArrayView<const InstructionOperand*>(tempOperands), captureLists)) {
+                    branch.bank->setRelativePosition(branch.position);
+                    inRange = instruction->encoding->checkRange(branch.bank, instruction->options, captureLists);
+                }
+
+                tempOperands.clear();
+                tempResolvedOperands.clear();
+            }
+
+            if (!inRange && promoteBranch(branch.index)) {
+                ++promotedCount;
+            }
         }
 
-        irNodeIndexesToRemove.clear();
+        return promotedCount;
+    }
 
-        if (!report->validate()) {
+    bool Compiler::promoteBranch(std::size_t index) {
+        const auto instruction = irNodes.getInstruction(index);
+        const auto distanceHint = irNodes.getOperandRoots(index)[0].operand->variant.tryGet<InstructionOperand::Integer>();
+        if (distanceHint == nullptr) {
             return false;
         }
 
-        for (auto& bank : registeredBanks) {
-            bank->rewind();
+        // Select the instruction again as if it had one more `^` in front of it.
+        auto previousDistanceHint = irNodes.replaceOperand(index, 0, makeFwdUnique<const InstructionOperand>(InstructionOperand::Integer(distanceHint->value + Int128(1))));
+        const auto promotedInstruction = builtins.selectInstruction(instruction->signature.type, irNodes.getModeFlags(index), irNodes.getOperandRoots(index));
+        if (promotedInstruction != nullptr && promotedInstruction != instruction) {
+            irNodes.replaceInstruction(index, promotedInstruction);
+            return true;
         }
 
-        std::vector<std::uint8_t> tempBuffer;
-        std::vector<FwdUniquePtr<const Expression>> tempExpressions;
-        std::vector<InstructionOperandRoot> tempOperandRoots;
+        irNodes.replaceOperand(index, 0, std::move(previousDistanceHint));
+        return false;
+    }
 
-        // Second pass: resolve all link-time expressions, write the instructions into the correct banks.
-        for (const auto& irNode : irNodes) {
-            const auto& variant = irNode->variant;
-            switch (variant.index()) {
-                case IrNode::VariantType::typeIndexOf<IrNode::PushRelocation>(): {
-                    const auto& pushRelocation = variant.get<IrNode::PushRelocation>();
-                    bankStack.push_back(currentBank);
-                    currentBank = pushRelocation.bank;
+    bool Compiler::resolveLinkTimeData(ResolvedInitializers& resolvedInitializers) {
+        std::vector<const InstructionOperand*> operands;
+        std::vector<FwdUniquePtr<const InstructionOperand>> resolvedOperands;
 
-                    if (const auto address = pushRelocation.address.tryGet()) {
-                        currentBank->absoluteSeek(report, *address, irNode->location);
+        for (std::size_t i = 0; i != irNodes.size(); ++i) {
+            const auto& location = irNodes.getLocation(i);
+            switch (irNodes.getKind(i)) {
+                case IrNodeKind::Code: {
+                    const auto operandRoots = irNodes.getOperandRoots(i);
+                    if (!resolveLinkTimeOperands(operandRoots, location, operands, resolvedOperands)) {
+                        break;
+                    }
+
+                    // Keep the resolved operands in place of the placeholders, so the instruction can be encoded without the rest of the compiler.
+                    std::size_t resolvedIndex = 0;
+                    for (std::size_t j = 0; j != operandRoots.size(); ++j) {
+                        if (operandRoots[j].linkTimeDependent) {
+                            irNodes.replaceOperand(i, j, std::move(resolvedOperands[resolvedIndex++]));
+                        }
                     }
                     break;
                 }
-                case IrNode::VariantType::typeIndexOf<IrNode::PopRelocation>(): {
-                    currentBank = bankStack.back();
-                    bankStack.pop_back();
-                    break;
-                }
-                case IrNode::VariantType::typeIndexOf<IrNode::Label>(): {
-                    const auto& label = variant.get<IrNode::Label>();
-                    Address labelAddress;
-
-                    auto& funcDefinition = label.definition->variant.get<Definition::Func>();
-                    labelAddress = funcDefinition.address.get();
-
-                    const auto currentBankAddress = currentBank->getAddress();
-                    if (labelAddress != currentBankAddress) {
-                        std::string message = "label `" + label.definition->name.toString() + "` was supposed to be at ";
+                case IrNodeKind::Var: {
+                    const auto& varDefinition = irNodes.getDefinition(i)->variant.get<Definition::Var>();
+                    const Expression* initializerExpression = varDefinition.initializerExpression.get();
 
-                        if (labelAddress.absolutePosition.hasValue()) {
-                            message += "absolute address 0x" + Int128(labelAddress.absolutePosition.get()).toString(16);
-                        } else {
-                            message += "relative position " + std::to_string(labelAddress.relativePosition.get());
+                    if (initializerExpression != nullptr && initializerExpression->info->context == EvaluationContext::LinkTime) {
+                        if (auto reducedExpression = reduceExpression(initializerExpression)) {
+                            auto convertedExpression = createConvertedExpression(reducedExpression.get(), varDefinition.resolvedType);
+                            initializerExpression = convertedExpression.get();
+                            resolvedInitializers.reducedExpressions.push_back(std::move(convertedExpression));
                         }
+                    }
 
-                        message += ", but bank is at ";
+                    ArrayView<std::uint8_t> data;
+                    if (initializerExpression == nullptr || !tryGetConstantInitializerData(initializerExpression, data)) {
+                        std::vector<std::uint8_t> buffer;
+                        buffer.reserve(varDefinition.storageSize.get());
 
-                        if (currentBankAddress.absolutePosition.hasValue()) {
-                            message += "absolute address 0x" + Int128(currentBankAddress.absolutePosition.get()).toString(16);
-                        } else {
-                            message += "relative position " + std::to_string(currentBankAddress.relativePosition.get());
+                        if (initializerExpression == nullptr) {
+                            buffer.resize(varDefinition.storageSize.get());
+                        } else if (!serializeConstantInitializer(initializerExpression, buffer)) {
+                            report->error("constant initializer could not be resolved at compile-time", location, ReportErrorFlags::of<ReportErrorFlagType::Fatal>());
                         }
 
-                        report->error(message, irNode->location, ReportErrorFlags::of<ReportErrorFlagType::InternalError>());
+                        // The buffer keeps its storage when it is moved, so the view stays valid.
+                        data = ArrayView<std::uint8_t>(buffer);
+                        resolvedInitializers.serializedData.push_back(std::move(buffer));
                     }
+
+                    resolvedInitializers.data.push_back(data);
                     break;
                 }
-                case IrNode::VariantType::typeIndexOf<IrNode::Code>(): {
-                    const auto& code = variant.get<IrNode::Code>();
-                    const auto& instruction = code.instruction;
+                default: break;
+            }
+        }
+
+        return report->validate();
+    }
+
+    void Compiler::emitBank(EmitTask& task, std::vector<EmitSegment>& segments, const ResolvedInitializers& resolvedInitializers, InstructionCaptureLists& captureLists) const {
+        // This may run on another thread at the same time as other tasks.
+        // It only writes to its own bank, task and segments. Everything else, like the IR and definitions, is only read.
+        const auto bank = task.bank;
+        const auto taskReport = &task.report;
+
+        for (const auto segmentIndex : task.segmentIndices) {
+            auto& segment = segments[segmentIndex];
+            auto initializerIndex = segment.initializerIndex;
+            segment.errorBegin = taskReport->getDeferredErrors().size();
+
+            for (auto i = segment.begin; i != segment.end; ++i) {
+                const auto& location = irNodes.getLocation(i);
+                switch (irNodes.getKind(i)) {
+                    case IrNodeKind::PushRelocation: {
+                        if (const auto address = irNodes.getRelocation(i).address.tryGet()) {
+                            bank->absoluteSeek(taskReport, *address, location);
+                        }
+                        break;
+                    }
+                    case IrNodeKind::PopRelocation: break;
+                    case IrNodeKind::Label: {
+                        const auto definition = irNodes.getDefinition(i);
+                        Address labelAddress;
 
-                    tempOperandRoots.clear();
-                    tempExpressions.clear();
+                        auto& funcDefinition = definition->variant.get<Definition::Func>();
+                        labelAddress = funcDefinition.address.get();
 
-                    bool failed = false;
+                        const auto currentBankAddress = bank->getAddress();
+                        if (labelAddress != currentBankAddress) {
+                            std::string message = "label `" + definition->name.toString() + "` was supposed to be at ";
 
-                    for (std::size_t i = 0; i != code.operandRoots.size() && !failed; ++i) {
-                        const auto& operandRoot = code.operandRoots[i];
-                        if (const auto expression = operandRoot.expression) {
-                            if (auto reducedExpression = reduceExpression(expression)) {
-                                if (auto operand = createOperandFromExpression(reducedExpression.get(), true)) {
-                                    tempOperandRoots.push_back(InstructionOperandRoot(reducedExpression.get(), std::move(operand)));
-                                    tempExpressions.push_back(std::move(reducedExpression));
-                                } else {
-                                    report->error("failed to create operand for reduced expresion", irNode->location, ReportErrorFlags::of<ReportErrorFlagType::InternalError>());
-                                    failed = true;
-                                    break;
-                                }
+                            if (labelAddress.absolutePosition.hasValue()) {
+                                message += "absolute address 0x" + Int128(labelAddress.absolutePosition.get()).toString(16);
                             } else {
-                                failed = true;
-                                break;
+                                message += "relative position " + std::to_string(labelAddress.relativePosition.get());
                             }
-                        } else {
-                            tempOperandRoots.push_back(InstructionOperandRoot(nullptr, operandRoot.operand->clone()));
-                        }
-                    }
 
-                    if (failed) {
-                        break;
-                    }
+                            message += ", but bank is at ";
 
-                    if (instruction->signature.extract(tempOperandRoots, captureLists)) {
-                        tempBuffer.clear();
-                        instruction->encoding->write(report, currentBank, tempBuffer, instruction->options, captureLists, irNode->location);
-                        if (!currentBank->write(report, "code"_sv, irNode.get(), irNode->location, tempBuffer)) {
-                            break;
+                            if (currentBankAddress.absolutePosition.hasValue()) {
+                                message += "absolute address 0x" + Int128(currentBankAddress.absolutePosition.get()).toString(16);
+                            } else {
+                                message += "relative position " + std::to_string(currentBankAddress.relativePosition.get());
+                            }
+
+                            taskReport->error(message, location, ReportErrorFlags::of<ReportErrorFlagType::InternalError>());
                         }
-                    } else {
-                        report->error("failed to extract instruction capture list during generation pass", irNode->location, ReportErrorFlags::of<ReportErrorFlagType::InternalError>());
+                        break;
                     }
-                    break;
-                }
-                case IrNode::VariantType::typeIndexOf<IrNode::Var>(): {
-                    const auto& var = variant.get<IrNode::Var>();
-                    auto& varDefinition = var.definition->variant.get<Definition::Var>();
+                    case IrNodeKind::Code: {
+                        const auto instruction = irNodes.getInstruction(i);
 
-                    Optional<std::size_t> oldPosition;
-                    if (varDefinition.addressExpression != nullptr) {
-                        oldPosition = currentBank->getRelativePosition();
-                        currentBank->setRelativePosition(varDefinition.address.get().relativePosition.get());
-                    }
+                        // Encode straight into the space that the bank reserved for this instruction.
+                        const auto allocationCount = getHeapAllocationCount();
+                        if (instruction->signature.extract(irNodes.getOperandRoots(i), captureLists)) {
+                            const auto size = instruction->encoding->calculateSize(instruction->options, captureLists);
 
-                    FwdUniquePtr<const Expression> tempExpression;
-                    const auto hasInitializer = varDefinition.initializerExpression.get() != nullptr;
-                    const Expression* finalInitializerExpression = varDefinition.initializerExpression.get();
-                    
-                    if (hasInitializer && varDefinition.initializerExpression->info->context == EvaluationContext::LinkTime) {
-                        if (auto reducedExpression = reduceExpression(varDefinition.initializerExpression.get())) {
-                             tempExpression = createConvertedExpression(reducedExpression.get(), varDefinition.resolvedType);
-                             finalInitializerExpression = tempExpression.get();
+                            std::uint8_t* dest = nullptr;
+                            if (!bank->beginWrite(taskReport, "code"_sv, irNodes.getOwner(i), location, size, dest)) {
+                                break;
+                            }
+
+                            InstructionBuffer buffer(dest, size);
+                            if (instruction->encoding->write(taskReport, bank, buffer, instruction->options, captureLists, location)
+                            && (buffer.hasOverflowed() || buffer.size() != size)) {
+                                taskReport->error("instruction encoding did not write the " + std::to_string(size) + " byte(s) that it reserved", location, ReportErrorFlags::of<ReportErrorFlagType::InternalError>());
+                            }
+                            bank->endWrite(size);
+
+                            task.encodingHeapAllocations += getHeapAllocationCount() - allocationCount;
+                            ++task.encodedInstructionCount;
+                        } else {
+                            taskReport->error("failed to extract instruction capture list during generation pass", location, ReportErrorFlags::of<ReportErrorFlagType::InternalError>());
                         }
+                        break;
                     }
- 
-                    tempBuffer.clear();
-                    tempBuffer.reserve(varDefinition.storageSize.get());
+                    case IrNodeKind::Var: {
+                        const auto& varDefinition = irNodes.getDefinition(i)->variant.get<Definition::Var>();
+                        const auto data = resolvedInitializers.data[initializerIndex++];
+
+                        Optional<std::size_t> oldPosition;
+                        if (varDefinition.addressExpression != nullptr) {
+                            oldPosition = bank->getRelativePosition();
+                            bank->setRelativePosition(varDefinition.address.get().relativePosition.get());
+                        }
 
-                    if (hasInitializer) {
-                        if (!serializeConstantInitializer(finalInitializerExpression, tempBuffer)) {
-                            report->error("constant initializer could not be resolved at compile-time", irNode->location, ReportErrorFlags::of<ReportErrorFlagType::Fatal>());
+                        if (!bank->write(taskReport, "constant data"_sv, irNodes.getOwner(i), location, data)) {
                             break;
                         }
-                    } else {
-                        tempBuffer.resize(varDefinition.storageSize.get());
-                    }
 
-                    if (!currentBank->write(report, "constant data"_sv, irNode.get(), irNode->location, tempBuffer)) {
+                        if (oldPosition.hasValue()) {
+                            bank->setRelativePosition(oldPosition.get());
+                        }
                         break;
                     }
- 
-                    if (oldPosition.hasValue()) {
-                        currentBank->setRelativePosition(oldPosition.get());
-                    }
+                    default: std::abort(); return;
+                }
+            }
+
+            segment.errorEnd = taskReport->getDeferredErrors().size();
+        }
+    }
+
+    bool Compiler::generateCode() {
+        for (auto& bank : registeredBanks) {
+            bank->saveReservations();
+        }
+
+        InstructionCaptureLists captureLists;
+        std::vector<std::size_t> irNodesToRemove;
+        std::vector<RelaxableBranch> relaxableBranches;
+        std::vector<const InstructionOperand*> tempOperands;
+        tempOperands.reserve(InstructionCaptureLists::MaxOperandRoots);
+        std::vector<FwdUniquePtr<const InstructionOperand>> tempResolvedOperands;
+
+        // Branches start out in the shortest form that the distance hint allows.
+        // After each layout, any that can't reach their destination are promoted to a longer form, and the layout is done again.
+        // Branches only ever grow, so this settles once a layout needs no more promotions.
+        while (true) {
+            ++layoutPassCount;
+
+            if (!layoutCode(captureLists, irNodesToRemove, relaxableBranches)) {
+                return false;
+            }
+
+            const auto promotedCount = relaxBranches(relaxableBranches, captureLists, tempOperands, tempResolvedOperands);
+            relaxedBranchCount += promotedCount;
+
+            irNodes.remove(irNodesToRemove);
+
+            if (!report->validate()) {
+                return false;
+            }
+            if (promotedCount == 0) {
+                break;
+            }
+
+            for (auto& bank : registeredBanks) {
+                bank->restoreReservations();
+            }
+        }
+
+        // Second pass: now that every address is known, resolve the link-time operands and initializers in place.
+        // This needs the rest of the compiler, so unlike the final pass, it all happens on this thread.
+        ResolvedInitializers resolvedInitializers;
+        if (!resolveLinkTimeData(resolvedInitializers)) {
+            return false;
+        }
+
+        for (auto& bank : registeredBanks) {
+            bank->rewind();
+        }
+
+        // Split the IR into runs of nodes that are written into the same bank, and give each bank a task that writes its runs in order.
+        std::vector<EmitSegment> segments;
+        std::vector<std::unique_ptr<EmitTask>> tasks;
+        std::unordered_map<const Bank*, std::size_t> bankTaskIndices;
+        std::size_t initializerIndex = 0;
+
+        segments.push_back(EmitSegment(currentBank, 0, 0));
+        for (std::size_t i = 0; i != irNodes.size(); ++i) {
+            switch (irNodes.getKind(i)) {
+                case IrNodeKind::PushRelocation: {
+                    bankStack.push_back(currentBank);
+                    currentBank = irNodes.getRelocation(i).bank;
+                    segments.back().end = i;
+                    segments.push_back(EmitSegment(currentBank, i, initializerIndex));
                     break;
                 }
-                default: std::abort(); return false;
+                case IrNodeKind::PopRelocation: {
+                    currentBank = bankStack.back();
+                    bankStack.pop_back();
+                    segments.back().end = i;
+                    segments.push_back(EmitSegment(currentBank, i, initializerIndex));
+                    break;
+                }
+                case IrNodeKind::Var: {
+                    ++initializerIndex;
+                    break;
+                }
+                default: break;
+            }
+        }
+        segments.back().end = irNodes.size();
+
+        for (std::size_t i = 0; i != segments.size(); ++i) {
+            auto& segment = segments[i];
+            if (segment.bank == nullptr || segment.begin == segment.end) {
+                continue;
+            }
+
+            const auto match = bankTaskIndices.find(segment.bank);
+            if (match != bankTaskIndices.end()) {
+                segment.taskIndex = match->second;
+            } else {
+                segment.taskIndex = tasks.size();
+                bankTaskIndices[segment.bank] = tasks.size();
+                tasks.push_back(std::make_unique<EmitTask>(segment.bank));
             }
+
+            tasks[segment.taskIndex]->segmentIndices.push_back(i);
+        }
+
+        // Final pass: encode the instructions and write the data into their banks.
+        // Banks no longer depend on each other, so each one can be written on its own thread.
+#ifdef WIZ_THREADS
+        std::atomic<std::size_t> nextIndex(0);
+        const auto work = [&]() {
+            InstructionCaptureLists threadCaptureLists;
+            for (auto i = nextIndex++; i < tasks.size(); i = nextIndex++) {
+                emitBank(*tasks[i], segments, resolvedInitializers, threadCaptureLists);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1, count = std::min(jobCount, tasks.size()); i < count; ++i) {
+            threads.emplace_back(work);
+        }
+
+        work();
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+#else
+        for (auto& task : tasks) {
+            emitBank(*task, segments, resolvedInitializers, captureLists);
+        }
+#endif
+
+        // Pass the errors along in IR order, so that they come out the same no matter how the tasks were scheduled.
+        for (const auto& segment : segments) {
+            if (segment.errorBegin != segment.errorEnd) {
+                const auto& errors = tasks[segment.taskIndex]->report.getDeferredErrors();
+                for (auto i = segment.errorBegin; i != segment.errorEnd; ++i) {
+                    report->error(errors[i].message, errors[i].location, errors[i].flags);
+                }
+            }
+        }
+
+        for (const auto& task : tasks) {
+            encodedInstructionCount += task->encodedInstructionCount;
+            encodingHeapAllocations += task->encodingHeapAllocations;
         }
+        emittedBankCount += tasks.size();
 
         return report->validate();
     }
@@ -1,7 +1,6 @@
 #ifndef WIZ_COMPILER_COMPILER_H
 #define WIZ_COMPILER_COMPILER_H
 
-#include <set>
 #include <memory>
 #include <string>
 #include <vector>
@@ -10,7 +9,12 @@
 #include <unordered_map>
 
 #include <wiz/compiler/instruction.h>
+#include <wiz/compiler/ir_node.h>
 #include <wiz/compiler/builtins.h>
+#include <wiz/compiler/expression_cache.h>
+#include <wiz/compiler/expression_program.h>
+#include <wiz/compiler/type_table.h>
+#include <wiz/compiler/symbol_table.h>
 #include <wiz/utility/string_pool.h>
 #include <wiz/utility/fwd_unique_ptr.h>
 #include <wiz/utility/int128.h>
@@ -18,6 +22,7 @@
 #include <wiz/utility/source_location.h>
 #include <wiz/utility/ptr_pool.h>
 #include <wiz/utility/array_view.h>
+#include <wiz/utility/report.h>
 
 namespace wiz {
     enum class BranchKind;
@@ -27,12 +32,10 @@ namespace wiz {
 
     class Bank;
     class Config;
-    class Report;
     class Platform;
-    class SymbolTable;
+    class Reader;
     class ImportManager;
 
-    struct IrNode;
     struct Attribute;
     struct Statement;
     struct Definition;
@@ -52,6 +55,9 @@ namespace wiz {
                 std::unordered_map<StringView, FwdUniquePtr<const Expression>> defines);
             ~Compiler();
 
+            // Sets how many threads may be used to write code and data into banks once every address is known. 1 disables this.
+            void setJobCount(std::size_t value);
+
             bool compile();
 
             Report* getReport() const;
@@ -59,6 +65,18 @@ namespace wiz {
             std::vector<const Bank*> getRegisteredBanks() const;
             std::vector<const Definition*> getRegisteredDefinitions() const;
             const Builtins& getBuiltins() const;
+            const ExpressionCache& getExpressionCache() const;
+            const TypeTable& getTypeTable() const;
+            std::size_t getLetCacheHits() const;
+            std::size_t getLetCacheMisses() const;
+            std::size_t getExpressionProgramCount() const;
+            std::size_t getExpressionProgramEvaluations() const;
+            std::size_t getExpressionProgramFallbacks() const;
+            std::size_t getEncodedInstructionCount() const;
+            std::size_t getEncodingHeapAllocations() const;
+            std::size_t getLayoutPassCount() const;
+            std::size_t getRelaxedBranchCount() const;
+            std::size_t getEmittedBankCount() const;
             std::uint32_t getModeFlags() const;
 
             FwdUniquePtr<InstructionOperand> createOperandFromExpression(const Expression* expression, bool quiet) const;
@@ -80,17 +98,31 @@ namespace wiz {
 
             bool enterLetExpression(StringView name, SourceLocation location);
             void exitLetExpression();
+            bool isLetCacheable(const Definition* definition) const;
+            bool isCacheableLetArgument(const Expression* expression) const;
+            bool isSameLetArgument(const Expression* left, const Expression* right) const;
+
+            FwdUniquePtr<ExpressionProgram> compileExpressionProgram(const Expression* expression, const std::vector<StringView>& inputNames);
+            bool compileExpressionProgramNode(ExpressionProgram& program, const Expression* expression, const std::vector<std::pair<StringView, ExpressionProgram::Register>>& bindings, std::size_t depth, ExpressionProgram::Register& result, SourceLocation& resultLocation);
+            bool tryGetExpressionProgramValue(const Expression* expression, ExpressionProgram::Value& value) const;
+            FwdUniquePtr<const Expression> evaluateExpressionProgram(ExpressionProgram& program);
 
             Definition* createAnonymousLabelDefinition(StringView label);
 
             void raiseUnresolvedIdentifierError(const std::vector<StringView>& pieces, std::size_t pieceIndex, SourceLocation location);
             std::pair<Definition*, std::size_t> resolveIdentifier(const std::vector<StringView>& pieces, SourceLocation location);
             FwdUniquePtr<const TypeExpression> reduceTypeExpression(const TypeExpression* typeExpression);
+            FwdUniquePtr<const TypeExpression> reduceTypeExpressionNode(const TypeExpression* typeExpression);
             FwdUniquePtr<const Expression> reduceExpression(const Expression* expression);
+            FwdUniquePtr<const Expression> reduceExpressionNode(const Expression* expression);
             Optional<std::size_t> tryGetSequenceLiteralLength(const Expression* expression) const;
-            FwdUniquePtr<const Expression> getSequenceLiteralItem(const Expression* expression, std::size_t index) const;
+            FwdUniquePtr<const Expression> getSequenceLiteralItem(const Expression* expression, std::size_t index);
             FwdUniquePtr<const Expression> createStringLiteralExpression(StringView data, SourceLocation location) const;
             FwdUniquePtr<const Expression> createArrayLiteralExpression(std::vector<FwdUniquePtr<const Expression>> items, const TypeExpression* elementType, SourceLocation location) const;
+            FwdUniquePtr<const Expression> createPackedArrayLiteralExpression(std::vector<std::uint8_t> data, Definition* elementType, SourceLocation location) const;
+            FwdUniquePtr<const Expression> tryCreatePackedArrayLiteralExpression(const std::vector<FwdUniquePtr<const Expression>>& items, const TypeExpression* elementType, SourceLocation location) const;
+            Definition* tryGetPackedElementType(const TypeExpression* elementType) const;
+            Int128 getPackedArrayLiteralValue(const Expression* expression, std::size_t index) const;
             std::string getResolvedIdentifierName(Definition* definition, const std::vector<StringView>& pieces) const;
             FwdUniquePtr<const Expression> resolveDefinitionExpression(Definition* definition, const std::vector<StringView>& pieces, SourceLocation location);
             FwdUniquePtr<const Expression> resolveTypeMemberExpression(const TypeExpression* typeExpression, StringView name);
@@ -118,10 +150,13 @@ namespace wiz {
             FwdUniquePtr<const Expression> createConvertedExpression(const Expression* sourceExpression, const TypeExpression* destinationType) const;
             bool isTypeEquivalent(const TypeExpression* leftTypeExpression, const TypeExpression* rightTypeExpression) const;
             std::string getTypeName(const TypeExpression* typeExpression) const;
+            std::string getUncachedTypeName(const TypeExpression* typeExpression) const;
             Optional<std::size_t> calculateStorageSize(const TypeExpression* typeExpression, StringView description) const;
+            Optional<std::size_t> calculateUncachedStorageSize(const TypeExpression* typeExpression, StringView description) const;
             Optional<std::size_t> resolveExplicitAddressExpression(const Expression* expression);
             bool serializeInteger(Int128 value, std::size_t size, std::vector<std::uint8_t>& result) const;
             bool serializeConstantInitializer(const Expression* expression, std::vector<std::uint8_t>& result) const;
+            bool tryGetConstantInitializerData(const Expression* expression, ArrayView<std::uint8_t>& result) const;
             std::pair<bool, Optional<std::size_t>> handleInStatement(const std::vector<StringView>& bankIdentifierPieces, const Expression* dest, SourceLocation location);
 
             struct CompiledAttributeList;
@@ -152,7 +187,7 @@ namespace wiz {
             void raiseEmitLoadError(const Expression* dest, const Expression* source, SourceLocation location);
             void raiseEmitUnaryExpressionError(const Expression* dest, UnaryOperatorKind op, const Expression* source, SourceLocation location);
             void raiseEmitBinaryExpressionError(const Expression* dest, BinaryOperatorKind op, const Expression* left, const Expression* right, SourceLocation location);
-            void raiseEmitIntrinsicError(const InstructionType& instructionType, const std::vector<InstructionOperandRoot>& operandRoots, SourceLocation location);
+            void raiseEmitIntrinsicError(const InstructionType& instructionType, ArrayView<InstructionOperandRoot> operandRoots, SourceLocation location);
 
             bool emitAssignmentExpressionIr(const Expression* dest, const Expression* source, SourceLocation location);
             bool emitExpressionStatementIr(const Expression* expression, SourceLocation location);
@@ -163,8 +198,78 @@ namespace wiz {
             bool hasUnconditionalReturn(const Statement* statement) const;
             bool emitFunctionIr(Definition* definition, SourceLocation location);
             bool emitStatementIr(const Statement* statement);
+
+            // A branch that might be too short to reach its destination, and where it was placed by the latest layout.
+            struct RelaxableBranch {
+                RelaxableBranch(
+                    std::size_t index,
+                    Bank* bank,
+                    std::size_t position)
+                : index(index),
+                bank(bank),
+                position(position) {}
+
+                std::size_t index;
+                Bank* bank;
+                std::size_t position;
+            };
+
+            bool layoutCode(InstructionCaptureLists& captureLists, std::vector<std::size_t>& irNodesToRemove, std::vector<RelaxableBranch>& relaxableBranches);
+            bool resolveLinkTimeOperands(ArrayView<InstructionOperandRoot> operandRoots, SourceLocation location, std::vector<const InstructionOperand*>& operands, std::vector<FwdUniquePtr<const InstructionOperand>>& resolvedOperands);
+            std::size_t relaxBranches(const std::vector<RelaxableBranch>& relaxableBranches, InstructionCaptureLists& captureLists, std::vector<const InstructionOperand*>& tempOperands, std::vector<FwdUniquePtr<const InstructionOperand>>& tempResolvedOperands);
+            bool promoteBranch(std::size_t index);
+
+            // The data for each var in the IR, in order, once its link-time values are resolved.
+            struct ResolvedInitializers {
+                std::vector<ArrayView<std::uint8_t>> data;
+                // Owns any data that had to be serialized, or that points into an expression that had to be reduced.
+                std::vector<std::vector<std::uint8_t>> serializedData;
+                std::vector<FwdUniquePtr<const Expression>> reducedExpressions;
+            };
+
+            // A run of IR nodes that are all written into the same bank, starting at a relocation.
+            struct EmitSegment {
+                EmitSegment(
+                    Bank* bank,
+                    std::size_t begin,
+                    std::size_t initializerIndex)
+                : bank(bank),
+                begin(begin),
+                end(begin),
+                initializerIndex(initializerIndex) {}
+
+                Bank* bank;
+                std::size_t begin;
+                std::size_t end;
+                // Index of the first var of this segment in ResolvedInitializers::data.
+                std::size_t initializerIndex;
+                std::size_t taskIndex = 0;
+                // The errors that this segment added to the report of its task.
+                std::size_t errorBegin = 0;
+                std::size_t errorEnd = 0;
+            };
+
+            // Writes every segment of one bank, in order. Different banks can be written on different threads.
+            struct EmitTask {
+                EmitTask(Bank* bank)
+                : bank(bank) {}
+
+                Bank* bank;
+                std::vector<std::size_t> segmentIndices;
+                Report report;
+                std::size_t encodedInstructionCount = 0;
+                std::size_t encodingHeapAllocations = 0;
+            };
+
+            bool resolveLinkTimeData(ResolvedInitializers& resolvedInitializers);
+            void emitBank(EmitTask& task, std::vector<EmitSegment>& segments, const ResolvedInitializers& resolvedInitializers, InstructionCaptureLists& captureLists) const;
             bool generateCode();
 
+            // Declared first so that they are destroyed last, after everything that might still point at their shared nodes.
+            // Shared expressions refer to interned types, so the type table has to outlive the expression cache.
+            TypeTable typeTable;
+            ExpressionCache expressionCache;
+
             FwdUniquePtr<const Statement> program;
             Platform* platform = nullptr;
             StringPool* stringPool = nullptr;
@@ -173,18 +278,18 @@ namespace wiz {
             Report* report = nullptr;
             Builtins builtins;
 
-            std::unordered_map<StringView, SymbolTable*> moduleScopes;
+            InternedStringMap<SymbolTable*> moduleScopes;
 
             PtrPool<SymbolTable> registeredScopes;
             SymbolTable* currentScope = nullptr;
             std::vector<SymbolTable*> scopeStack;
 
             struct ResolveIdentifierState {
-                std::set<Definition*> previousResults;
-                std::set<Definition*> results;
+                SymbolTable::DefinitionList previousResults;
+                SymbolTable::DefinitionList results;
             } resolveIdentifierTempState;
 
-            std::set<Definition*> tempImportedDefinitions;
+            SymbolTable::DefinitionList tempImportedDefinitions;
 
             struct InlineSite {
                 std::unordered_map<const Statement*, SymbolTable*> statementScopes;
@@ -198,6 +303,8 @@ namespace wiz {
             std::vector<Definition*> definitionsToResolve;
 
             static const std::size_t MaxLetRecursionDepth = 128;
+            static const std::size_t MaxCachedLetCalls = 16;
+            static const std::size_t MaxExpressionProgramCallDepth = 16;
 
             struct LetExpressionStackItem {
                 LetExpressionStackItem(
@@ -210,6 +317,20 @@ namespace wiz {
             };
 
             std::vector<LetExpressionStackItem> letExpressionStack;
+            std::size_t letCacheHits = 0;
+            std::size_t letCacheMisses = 0;
+            std::size_t expressionProgramCount = 0;
+            std::size_t expressionProgramEvaluations = 0;
+            std::size_t expressionProgramFallbacks = 0;
+
+            std::size_t encodedInstructionCount = 0;
+            // Heap allocations made while capturing, encoding and writing the instructions in the final pass.
+            // Always 0 unless allocations are counted (see allocation_counter.h).
+            std::size_t encodingHeapAllocations = 0;
+            std::size_t layoutPassCount = 0;
+            std::size_t relaxedBranchCount = 0;
+            std::size_t emittedBankCount = 0;
+            std::size_t jobCount = 1;
 
             bool allowReservedConstants = false;
             std::vector<Definition*> reservedConstants;
@@ -251,13 +372,14 @@ namespace wiz {
             Definition* continueLabel = nullptr;
             Definition* returnLabel = nullptr;
 
-            std::unordered_map<StringView, StringView> embedCache;
+            InternedStringMap<StringView> embedCache;
+            std::vector<std::unique_ptr<Reader>> embedReaders;
 
             FwdPtrPool<Definition> definitionPool;
             FwdPtrPool<const Statement> statementPool;
             FwdPtrPool<const Expression> expressionPool;
-            FwdPtrPool<IrNode> irNodes;
-            std::unordered_map<StringView, std::size_t> labelSuffixes;
+            IrNodeList irNodes;
+            InternedStringMap<std::size_t> labelSuffixes;
     };
 }
 
@@ -3,8 +3,10 @@
 
 #include <type_traits>
 #include <memory>
+#include <vector>
 #include <cstddef>
 #include <cstdint>
+#include <utility>
 
 #include <wiz/ast/qualifiers.h>
 #include <wiz/compiler/address.h>
@@ -22,6 +24,7 @@ namespace wiz {
 
     class Bank;
     class SymbolTable;
+    class ExpressionProgram;
 
     enum class BankKind;
     enum class StructKind;
@@ -147,14 +150,34 @@ namespace wiz {
         };
 
         struct Let {
+            struct CachedCall {
+                CachedCall(
+                    std::vector<FwdUniquePtr<const Expression>> arguments,
+                    FwdUniquePtr<const Expression> result)
+                : arguments(std::move(arguments)),
+                result(std::move(result)) {}
+
+                std::vector<FwdUniquePtr<const Expression>> arguments;
+                FwdUniquePtr<const Expression> result;
+            };
+
             Let(
                 const std::vector<StringView>& parameters,
                 const Expression* expression)
             : parameters(parameters),
-            expression(expression) {}
+            expression(expression),
+            programCompiled(false) {}
 
             std::vector<StringView> parameters;
             const Expression* expression;
+
+            // Compile-time results of reducing the expression, kept so later references don't need to reduce it again.
+            FwdUniquePtr<const Expression> reducedExpression;
+            std::vector<CachedCall> cachedCalls;
+
+            // Bytecode for a `let` function, compiled after its first successful call. May stay null if the expression isn't supported.
+            FwdUniquePtr<ExpressionProgram> program;
+            bool programCompiled;
         };
 
         struct Namespace {
@@ -0,0 +1,256 @@
+#include <cstdint>
+#include <utility>
+
+#include <wiz/ast/expression.h>
+#include <wiz/ast/type_expression.h>
+#include <wiz/compiler/expression_cache.h>
+
+namespace wiz {
+    namespace {
+        // Must be a power of two.
+        const std::size_t RecentNodeCount = 4096;
+
+        void combineHash(std::size_t& hash, std::size_t value) {
+            hash ^= value + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+        }
+
+        // Paths, identifier pieces, suffixes and string literals are hashed and compared by identity, never by contents.
+        // Most of them are interned, and equal text at a different address just means a node doesn't get shared.
+        std::size_t getIdentityHash(StringView text) {
+            return reinterpret_cast<std::uintptr_t>(text.getData()) ^ text.getLength();
+        }
+
+        bool isSameIdentity(StringView left, StringView right) {
+            return left.getData() == right.getData() && left.getLength() == right.getLength();
+        }
+
+        bool isSamePieces(const std::vector<StringView>& left, const std::vector<StringView>& right) {
+            if (left.size() != right.size()) {
+                return false;
+            }
+            for (std::size_t i = 0, size = left.size(); i != size; ++i) {
+                if (!isSameIdentity(left[i], right[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool isSameLocation(const SourceLocation& left, const SourceLocation& right) {
+            return left.line == right.line
+                && isSameIdentity(left.displayPath, right.displayPath)
+                && isSameIdentity(left.canonicalPath, right.canonicalPath);
+        }
+
+        void hashPieces(std::size_t& hash, const std::vector<StringView>& pieces) {
+            for (const auto& piece : pieces) {
+                combineHash(hash, getIdentityHash(piece));
+            }
+        }
+
+        void hashLocation(std::size_t& hash, const SourceLocation& location) {
+            combineHash(hash, location.line);
+            combineHash(hash, getIdentityHash(location.displayPath));
+            combineHash(hash, getIdentityHash(location.canonicalPath));
+        }
+
+        bool isShareable(const Expression* expression) {
+            // Types are part of the key, and interned types can be compared by address.
+            if (expression->info.hasValue()) {
+                const auto type = expression->info->type.get();
+                if (type != nullptr && type->canonical == nullptr) {
+                    return false;
+                }
+            }
+
+            const auto& variant = expression->variant;
+            switch (variant.index()) {
+                case Expression::VariantType::typeIndexOf<Expression::BooleanLiteral>():
+                case Expression::VariantType::typeIndexOf<Expression::IntegerLiteral>():
+                case Expression::VariantType::typeIndexOf<Expression::ResolvedIdentifier>():
+                case Expression::VariantType::typeIndexOf<Expression::StringLiteral>():
+                    return true;
+                case Expression::VariantType::typeIndexOf<Expression::BinaryOperator>(): {
+                    const auto& binaryOperator = variant.get<Expression::BinaryOperator>();
+                    return binaryOperator.left != nullptr && binaryOperator.left->shared
+                        && binaryOperator.right != nullptr && binaryOperator.right->shared;
+                }
+                case Expression::VariantType::typeIndexOf<Expression::FieldAccess>(): {
+                    const auto& fieldAccess = variant.get<Expression::FieldAccess>();
+                    return fieldAccess.operand != nullptr && fieldAccess.operand->shared;
+                }
+                case Expression::VariantType::typeIndexOf<Expression::UnaryOperator>(): {
+                    const auto& unaryOperator = variant.get<Expression::UnaryOperator>();
+                    return unaryOperator.operand != nullptr && unaryOperator.operand->shared;
+                }
+                default: return false;
+            }
+        }
+
+        std::size_t hashNode(const Expression* expression) {
+            const auto& variant = expression->variant;
+
+            std::size_t hash = variant.index();
+            hashLocation(hash, expression->location);
+
+            if (expression->info.hasValue()) {
+                const auto& info = *expression->info;
+                combineHash(hash, static_cast<std::size_t>(info.context));
+                combineHash(hash, info.qualifiers.underlying());
+                combineHash(hash, reinterpret_cast<std::uintptr_t>(info.type.get()));
+            }
+
+            switch (variant.index()) {
+                case Expression::VariantType::typeIndexOf<Expression::BinaryOperator>(): {
+                    const auto& binaryOperator = variant.get<Expression::BinaryOperator>();
+                    combineHash(hash, static_cast<std::size_t>(binaryOperator.op));
+                    combineHash(hash, reinterpret_cast<std::uintptr_t>(binaryOperator.left.get()));
+                    combineHash(hash, reinterpret_cast<std::uintptr_t>(binaryOperator.right.get()));
+                    break;
+                }
+                case Expression::VariantType::typeIndexOf<Expression::BooleanLiteral>(): {
+                    combineHash(hash, variant.get<Expression::BooleanLiteral>().value ? 1 : 0);
+                    break;
+                }
+                case Expression::VariantType::typeIndexOf<Expression::FieldAccess>(): {
+                    const auto& fieldAccess = variant.get<Expression::FieldAccess>();
+                    combineHash(hash, reinterpret_cast<std::uintptr_t>(fieldAccess.operand.get()));
+                    combineHash(hash, getIdentityHash(fieldAccess.field));
+                    break;
+                }
+                case Expression::VariantType::typeIndexOf<Expression::IntegerLiteral>(): {
+                    const auto& integerLiteral = variant.get<Expression::IntegerLiteral>();
+                    combineHash(hash, static_cast<std::size_t>(integerLiteral.value.low));
+                    combineHash(hash, static_cast<std::size_t>(integerLiteral.value.high));
+                    combineHash(hash, getIdentityHash(integerLiteral.suffix));
+                    break;
+                }
+                case Expression::VariantType::typeIndexOf<Expression::ResolvedIdentifier>(): {
+                    const auto& resolvedIdentifier = variant.get<Expression::ResolvedIdentifier>();
+                    combineHash(hash, reinterpret_cast<std::uintptr_t>(resolvedIdentifier.definition));
+                    hashPieces(hash, resolvedIdentifier.pieces);
+                    break;
+                }
+                case Expression::VariantType::typeIndexOf<Expression::StringLiteral>(): {
+                    combineHash(hash, getIdentityHash(variant.get<Expression::StringLiteral>().value));
+                    break;
+                }
+                case Expression::VariantType::typeIndexOf<Expression::UnaryOperator>(): {
+                    const auto& unaryOperator = variant.get<Expression::UnaryOperator>();
+                    combineHash(hash, static_cast<std::size_t>(unaryOperator.op));
+                    combineHash(hash, reinterpret_cast<std::uintptr_t>(unaryOperator.operand.get()));
+                    break;
+                }
+                default: break;
+            }
+
+            return hash;
+        }
+
+        bool isSameNode(const Expression* left, const Expression* right) {
+            if (left == right) {
+                return true;
+            }
+            if (left->variant.index() != right->variant.index()
+            || !isSameLocation(left->location, right->location)
+            || left->info.hasValue() != right->info.hasValue()) {
+                return false;
+            }
+
+            if (left->info.hasValue()) {
+                const auto& leftInfo = *left->info;
+                const auto& rightInfo = *right->info;
+                if (leftInfo.context != rightInfo.context
+                || leftInfo.qualifiers != rightInfo.qualifiers
+                || leftInfo.type.get() != rightInfo.type.get()) {
+                    return false;
+                }
+            }
+
+            const auto& leftVariant = left->variant;
+            const auto& rightVariant = right->variant;
+            switch (leftVariant.index()) {
+                case Expression::VariantType::typeIndexOf<Expression::BinaryOperator>(): {
+                    const auto& leftBinaryOperator = leftVariant.get<Expression::BinaryOperator>();
+                    const auto& rightBinaryOperator = rightVariant.get<Expression::BinaryOperator>();
+                    return leftBinaryOperator.op == rightBinaryOperator.op
+                        && leftBinaryOperator.left.get() == rightBinaryOperator.left.get()
+                        && leftBinaryOperator.right.get() == rightBinaryOperator.right.get();
+                }
+                case Expression::VariantType::typeIndexOf<Expression::BooleanLiteral>(): {
+                    return leftVariant.get<Expression::BooleanLiteral>().value == rightVariant.get<Expression::BooleanLiteral>().value;
+                }
+                case Expression::VariantType::typeIndexOf<Expression::FieldAccess>(): {
+                    const auto& leftFieldAccess = leftVariant.get<Expression::FieldAccess>();
+                    const auto& rightFieldAccess = rightVariant.get<Expression::FieldAccess>();
+                    return leftFieldAccess.operand.get() == rightFieldAccess.operand.get()
+                        && isSameIdentity(leftFieldAccess.field, rightFieldAccess.field);
+                }
+                case Expression::VariantType::typeIndexOf<Expression::IntegerLiteral>(): {
+                    const auto& leftIntegerLiteral = leftVariant.get<Expression::IntegerLiteral>();
+                    const auto& rightIntegerLiteral = rightVariant.get<Expression::IntegerLiteral>();
+                    return leftIntegerLiteral.value == rightIntegerLiteral.value
+                        && isSameIdentity(leftIntegerLiteral.suffix, rightIntegerLiteral.suffix);
+                }
+                case Expression::VariantType::typeIndexOf<Expression::ResolvedIdentifier>(): {
+                    const auto& leftResolvedIdentifier = leftVariant.get<Expression::ResolvedIdentifier>();
+                    const auto& rightResolvedIdentifier = rightVariant.get<Expression::ResolvedIdentifier>();
+                    return leftResolvedIdentifier.definition == rightResolvedIdentifier.definition
+                        && isSamePieces(leftResolvedIdentifier.pieces, rightResolvedIdentifier.pieces);
+                }
+                case Expression::VariantType::typeIndexOf<Expression::StringLiteral>(): {
+                    return isSameIdentity(leftVariant.get<Expression::StringLiteral>().value, rightVariant.get<Expression::StringLiteral>().value);
+                }
+                case Expression::VariantType::typeIndexOf<Expression::UnaryOperator>(): {
+                    const auto& leftUnaryOperator = leftVariant.get<Expression::UnaryOperator>();
+                    const auto& rightUnaryOperator = rightVariant.get<Expression::UnaryOperator>();
+                    return leftUnaryOperator.op == rightUnaryOperator.op
+                        && leftUnaryOperator.operand.get() == rightUnaryOperator.operand.get();
+                }
+                default: return false;
+            }
+        }
+    }
+
+    ExpressionCache::ExpressionCache()
+    : recentNodes(RecentNodeCount, nullptr),
+    hitCount(0) {}
+
+    ExpressionCache::~ExpressionCache() {
+        // Operands are always created before the nodes that use them, so destroy in reverse.
+        for (auto it = nodesInCreationOrder.rbegin(); it != nodesInCreationOrder.rend(); ++it) {
+            (*it)->~Expression();
+        }
+    }
+
+    FwdUniquePtr<const Expression> ExpressionCache::intern(FwdUniquePtr<const Expression> expression) {
+        if (expression == nullptr || expression->shared || !isShareable(expression.get())) {
+            return expression;
+        }
+        // Shared nodes live as long as the cache, so they can't come from an arena that is about to be reset.
+        if (Arena::getCurrent()->isTemporary()) {
+            return expression;
+        }
+
+        auto& slot = recentNodes[hashNode(expression.get()) & (RecentNodeCount - 1)];
+        if (slot != nullptr && isSameNode(slot, expression.get())) {
+            ++hitCount;
+            return FwdUniquePtr<const Expression>(slot);
+        }
+
+        // The node was built by the caller and hasn't been handed out anywhere else yet, so it can still be marked as shared.
+        const auto node = expression.release();
+        const_cast<Expression*>(node)->shared = true;
+        slot = node;
+        nodesInCreationOrder.push_back(node);
+        return FwdUniquePtr<const Expression>(node);
+    }
+
+    std::size_t ExpressionCache::getNodeCount() const {
+        return nodesInCreationOrder.size();
+    }
+
+    std::size_t ExpressionCache::getHitCount() const {
+        return hitCount;
+    }
+}
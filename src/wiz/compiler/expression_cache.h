@@ -0,0 +1,44 @@
+#ifndef WIZ_COMPILER_EXPRESSION_CACHE_H
+#define WIZ_COMPILER_EXPRESSION_CACHE_H
+
+#include <vector>
+#include <cstddef>
+
+#include <wiz/utility/fwd_unique_ptr.h>
+
+namespace wiz {
+    struct Expression;
+
+    // Best-effort cache of reduced expressions, so that re-reducing the same code can hand back the node it built last time.
+    // Only literals, resolved identifiers, and operators over other shared nodes are shared.
+    // Shared nodes are immutable and owned by the cache, so they must not outlive it.
+    //
+    // This is not structural hash-consing: equal nodes are not guaranteed to be shared, so nothing may compare shared nodes by address
+    // to decide whether they are equal. Source location is part of a node's key, since diagnostics rely on it,
+    // so duplicates are nearly always re-reductions of the same code shortly after. Lookups only go through a fixed-size,
+    // direct-mapped index of recently shared nodes, which stays in cache where a set of every node ever seen would not.
+    // Text is keyed by address rather than contents, so equal text at a different address just means a node doesn't get shared.
+    class ExpressionCache {
+        public:
+            ExpressionCache();
+            ~ExpressionCache();
+
+            // Returns an existing node equal to the given expression, or takes ownership of the expression if there isn't one yet.
+            // Inside an Arena::TemporaryScope, new nodes are handed back without being shared.
+            // Expressions that can't be shared are returned as-is.
+            FwdUniquePtr<const Expression> intern(FwdUniquePtr<const Expression> expression);
+
+            std::size_t getNodeCount() const;
+            std::size_t getHitCount() const;
+
+        private:
+            ExpressionCache(const ExpressionCache&) = delete;
+            ExpressionCache& operator=(const ExpressionCache&) = delete;
+
+            std::vector<const Expression*> recentNodes;
+            std::vector<const Expression*> nodesInCreationOrder;
+            std::size_t hitCount;
+    };
+}
+
+#endif
@@ -0,0 +1,301 @@
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+#include <wiz/ast/expression.h>
+#include <wiz/compiler/definition.h>
+#include <wiz/compiler/operations.h>
+#include <wiz/compiler/expression_program.h>
+#include <wiz/utility/fwd_unique_ptr.h>
+
+namespace wiz {
+    template <>
+    void FwdDeleter<ExpressionProgram>::operator()(const ExpressionProgram* ptr) {
+        delete ptr;
+    }
+
+    namespace {
+        bool isIntegerType(const Definition* type) {
+            return type->variant.is<Definition::BuiltinIntegerType>()
+                || type->variant.is<Definition::BuiltinIntegerExpressionType>();
+        }
+
+        bool isBooleanType(const Definition* type) {
+            return type->variant.is<Definition::BuiltinBoolType>();
+        }
+
+        bool isInRange(const Definition* type, Int128 value) {
+            if (const auto builtinIntegerType = type->variant.tryGet<Definition::BuiltinIntegerType>()) {
+                return value >= builtinIntegerType->min && value <= builtinIntegerType->max;
+            }
+            return true;
+        }
+
+        // Same rules as Compiler::findCompatibleBinaryArithmeticExpressionType.
+        Definition* findCompatibleIntegerType(const ExpressionProgram::Value& left, const ExpressionProgram::Value& right) {
+            if (!isIntegerType(left.type) || !isIntegerType(right.type)) {
+                return nullptr;
+            }
+            if (left.type == right.type) {
+                return left.type;
+            }
+            if (left.type->variant.is<Definition::BuiltinIntegerExpressionType>()
+            && right.type->variant.is<Definition::BuiltinIntegerType>()
+            && isInRange(right.type, left.value)) {
+                return right.type;
+            }
+            if (right.type->variant.is<Definition::BuiltinIntegerExpressionType>()
+            && left.type->variant.is<Definition::BuiltinIntegerType>()
+            && isInRange(left.type, right.value)) {
+                return left.type;
+            }
+            return nullptr;
+        }
+
+        Int128 getTypeMask(const Definition::BuiltinIntegerType& builtinIntegerType) {
+            return Int128((1U << (8U * builtinIntegerType.size)) - 1);
+        }
+
+        Int128 fromBool(bool value) {
+            return Int128(value ? 1 : 0);
+        }
+    }
+
+    ExpressionProgram::ExpressionProgram(
+        std::size_t inputCount,
+        Definition* boolType,
+        Definition* u8Type)
+    : inputCount(inputCount),
+    boolType(boolType),
+    u8Type(u8Type),
+    registers(inputCount),
+    result(0) {}
+
+    std::size_t ExpressionProgram::getInputCount() const {
+        return inputCount;
+    }
+
+    std::size_t ExpressionProgram::getRegisterCount() const {
+        return registers.size();
+    }
+
+    bool ExpressionProgram::isFull() const {
+        return registers.size() >= MaxRegisterCount;
+    }
+
+    ExpressionProgram::Register ExpressionProgram::addRegister(Value value) {
+        registers.push_back(value);
+        return static_cast<Register>(registers.size() - 1);
+    }
+
+    ExpressionProgram::Register ExpressionProgram::addConstant(Value value) {
+        return addRegister(value);
+    }
+
+    ExpressionProgram::Register ExpressionProgram::addUnaryOperator(UnaryOperatorKind op, Register operand) {
+        const auto dest = addRegister(Value());
+        instructions.push_back(Instruction(Opcode::UnaryOperator, op, BinaryOperatorKind::None, nullptr, dest, operand, 0));
+        return dest;
+    }
+
+    ExpressionProgram::Register ExpressionProgram::addBinaryOperator(BinaryOperatorKind op, Register left, Register right) {
+        const auto dest = addRegister(Value());
+        instructions.push_back(Instruction(Opcode::BinaryOperator, UnaryOperatorKind::None, op, nullptr, dest, left, right));
+        return dest;
+    }
+
+    ExpressionProgram::Register ExpressionProgram::addCast(Definition* type, Register operand) {
+        const auto dest = addRegister(Value());
+        instructions.push_back(Instruction(Opcode::Cast, UnaryOperatorKind::None, BinaryOperatorKind::None, type, dest, operand, 0));
+        return dest;
+    }
+
+    void ExpressionProgram::setResult(Register result, SourceLocation location) {
+        this->result = result;
+        resultLocation = location;
+    }
+
+    SourceLocation ExpressionProgram::getResultLocation() const {
+        return resultLocation;
+    }
+
+    void ExpressionProgram::setInput(std::size_t index, Value value) {
+        registers[index] = value;
+    }
+
+    bool ExpressionProgram::evaluate(Value& resultValue) {
+        for (const auto& instruction : instructions) {
+            const auto& left = registers[instruction.left];
+            const auto& right = registers[instruction.right];
+            auto& dest = registers[instruction.dest];
+
+            switch (instruction.opcode) {
+                case Opcode::UnaryOperator: {
+                    if (!applyUnaryOperator(instruction.unaryOp, left, dest)) {
+                        return false;
+                    }
+                    break;
+                }
+                case Opcode::BinaryOperator: {
+                    if (!applyBinaryOperator(instruction.binaryOp, left, right, dest)) {
+                        return false;
+                    }
+                    break;
+                }
+                case Opcode::Cast: {
+                    if (!applyCast(instruction.type, left, dest)) {
+                        return false;
+                    }
+                    break;
+                }
+                default: std::abort(); return false;
+            }
+        }
+
+        resultValue = registers[result];
+        return true;
+    }
+
+    bool ExpressionProgram::applyUnaryOperator(UnaryOperatorKind op, const Value& operand, Value& result) const {
+        switch (op) {
+            case UnaryOperatorKind::BitwiseNegation: {
+                if (isBooleanType(operand.type)) {
+                    result = Value(operand.type, fromBool(operand.value.isZero()));
+                    return true;
+                } else if (const auto builtinIntegerType = operand.type->variant.tryGet<Definition::BuiltinIntegerType>()) {
+                    result = Value(operand.type, ~operand.value & getTypeMask(*builtinIntegerType));
+                    return true;
+                } else if (operand.type->variant.is<Definition::BuiltinIntegerExpressionType>()) {
+                    result = Value(operand.type, ~operand.value);
+                    return true;
+                }
+                return false;
+            }
+            case UnaryOperatorKind::LogicalNegation: {
+                if (isBooleanType(operand.type)) {
+                    result = Value(operand.type, fromBool(operand.value.isZero()));
+                    return true;
+                }
+                return false;
+            }
+            case UnaryOperatorKind::SignedNegation: {
+                if (isIntegerType(operand.type)) {
+                    const auto negated = Int128().checkedSubtract(operand.value);
+                    if (negated.first == Int128::CheckedArithmeticResult::Success && isInRange(operand.type, negated.second)) {
+                        result = Value(operand.type, negated.second);
+                        return true;
+                    }
+                }
+                return false;
+            }
+            case UnaryOperatorKind::LowByte:
+            case UnaryOperatorKind::HighByte:
+            case UnaryOperatorKind::BankByte: {
+                std::size_t offset;
+                switch (op) {
+                    case UnaryOperatorKind::LowByte: offset = 0; break;
+                    case UnaryOperatorKind::HighByte: offset = 1; break;
+                    case UnaryOperatorKind::BankByte: offset = 2; break;
+                    default: std::abort(); return false;
+                }
+
+                if (!isIntegerType(operand.type)) {
+                    return false;
+                }
+                if (const auto builtinIntegerType = operand.type->variant.tryGet<Definition::BuiltinIntegerType>()) {
+                    if (offset >= builtinIntegerType->size) {
+                        return false;
+                    }
+                }
+
+                result = Value(u8Type, operand.value.logicalRightShift(8 * offset) & Int128(0xFF));
+                return true;
+            }
+            default: return false;
+        }
+    }
+
+    bool ExpressionProgram::applyBinaryOperator(BinaryOperatorKind op, const Value& left, const Value& right, Value& result) const {
+        if (isValidArithmeticOp(op)) {
+            if (isBooleanType(left.type) && isBooleanType(right.type)) {
+                switch (op) {
+                    case BinaryOperatorKind::BitwiseAnd: result = Value(boolType, left.value & right.value); return true;
+                    case BinaryOperatorKind::BitwiseOr: result = Value(boolType, left.value | right.value); return true;
+                    case BinaryOperatorKind::BitwiseXor: result = Value(boolType, left.value ^ right.value); return true;
+                    default: return false;
+                }
+            }
+
+            if (const auto resultType = findCompatibleIntegerType(left, right)) {
+                const auto value = applyIntegerArithmeticOp(op, left.value, right.value);
+                if (value.first == Int128::CheckedArithmeticResult::Success && isInRange(resultType, value.second)) {
+                    result = Value(resultType, value.second);
+                    return true;
+                }
+            }
+            return false;
+        } else if (isValidComparisonOp(op)) {
+            if (findCompatibleIntegerType(left, right) != nullptr) {
+                result = Value(boolType, fromBool(applyIntegerComparisonOp(op, left.value, right.value)));
+                return true;
+            } else if (isBooleanType(left.type) && isBooleanType(right.type)) {
+                result = Value(boolType, fromBool(applyBooleanComparisonOp(op, !left.value.isZero(), !right.value.isZero())));
+                return true;
+            }
+            return false;
+        }
+
+        switch (op) {
+            case BinaryOperatorKind::LogicalAnd:
+            case BinaryOperatorKind::LogicalOr: {
+                if (isBooleanType(left.type) && isBooleanType(right.type)) {
+                    const auto value = op == BinaryOperatorKind::LogicalAnd
+                        ? left.value & right.value
+                        : left.value | right.value;
+                    result = Value(boolType, value);
+                    return true;
+                }
+                return false;
+            }
+            case BinaryOperatorKind::BitIndexing: {
+                if (findCompatibleIntegerType(left, right) != nullptr) {
+                    std::size_t bits = right.value > Int128(SIZE_MAX) ? SIZE_MAX : static_cast<std::size_t>(right.value);
+                    result = Value(boolType, fromBool(left.value.getBit(bits)));
+                    return true;
+                }
+                return false;
+            }
+            case BinaryOperatorKind::LeftRotate:
+            case BinaryOperatorKind::RightRotate: {
+                if (const auto resultType = findCompatibleIntegerType(left, right)) {
+                    if (const auto builtinIntegerType = resultType->variant.tryGet<Definition::BuiltinIntegerType>()) {
+                        const auto typeBits = 8 * builtinIntegerType->size;
+                        std::size_t bits = right.value >= Int128(SIZE_MAX) ? SIZE_MAX : static_cast<std::size_t>(right.value);
+                        bits %= typeBits;
+
+                        const auto value = op == BinaryOperatorKind::LeftRotate
+                            ? left.value.logicalLeftShift(bits) | left.value.logicalRightShift(typeBits - bits)
+                            : left.value.logicalRightShift(bits) | left.value.logicalLeftShift(typeBits - bits);
+                        result = Value(resultType, value);
+                        return true;
+                    }
+                }
+                return false;
+            }
+            default: return false;
+        }
+    }
+
+    bool ExpressionProgram::applyCast(Definition* type, const Value& operand, Value& result) const {
+        if (!isIntegerType(operand.type)) {
+            return false;
+        }
+
+        if (const auto builtinIntegerType = type->variant.tryGet<Definition::BuiltinIntegerType>()) {
+            result = Value(type, operand.value & getTypeMask(*builtinIntegerType));
+        } else {
+            result = Value(type, operand.value);
+        }
+        return true;
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef WIZ_COMPILER_EXPRESSION_PROGRAM_H
+#define WIZ_COMPILER_EXPRESSION_PROGRAM_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <wiz/utility/int128.h>
+#include <wiz/utility/source_location.h>
+
+namespace wiz {
+    struct Definition;
+
+    enum class UnaryOperatorKind;
+    enum class BinaryOperatorKind;
+
+    // A compile-time expression flattened into register bytecode, so that it can be evaluated many times over
+    // without reducing its syntax tree again. Used for array comprehension bodies and `let` functions.
+    //
+    // Registers hold integer and boolean values, tagged with their type definition, because whether an `iexpr` can narrow
+    // to a sized integer type depends on its value. Every register is written at most once, so constants are stored
+    // in their registers up front, and inputs are written directly into the first registers.
+    //
+    // Evaluation gives up on anything the tree reducer would report as an error, leaving the caller to fall back
+    // to reducing the expression normally, so that diagnostics are unaffected.
+    class ExpressionProgram {
+        public:
+            using Register = std::uint16_t;
+
+            static const std::size_t MaxRegisterCount = 4096;
+
+            struct Value {
+                Value()
+                : type(nullptr),
+                value() {}
+
+                Value(
+                    Definition* type,
+                    Int128 value)
+                : type(type),
+                value(value) {}
+
+                // One of the `bool`, `iexpr` or sized integer type definitions. Booleans are stored as 0 or 1.
+                Definition* type;
+                Int128 value;
+            };
+
+            ExpressionProgram(
+                std::size_t inputCount,
+                Definition* boolType,
+                Definition* u8Type);
+
+            std::size_t getInputCount() const;
+            std::size_t getRegisterCount() const;
+            bool isFull() const;
+
+            Register addConstant(Value value);
+            Register addUnaryOperator(UnaryOperatorKind op, Register operand);
+            Register addBinaryOperator(BinaryOperatorKind op, Register left, Register right);
+            Register addCast(Definition* type, Register operand);
+
+            void setResult(Register result, SourceLocation location);
+            SourceLocation getResultLocation() const;
+
+            void setInput(std::size_t index, Value value);
+
+            // Runs the program against the current inputs.
+            // Returns false if any instruction would have been an error, in which case the result is left untouched.
+            bool evaluate(Value& result);
+
+        private:
+            enum class Opcode : std::uint8_t {
+                UnaryOperator,
+                BinaryOperator,
+                Cast,
+            };
+
+            struct Instruction {
+                Instruction(
+                    Opcode opcode,
+                    UnaryOperatorKind unaryOp,
+                    BinaryOperatorKind binaryOp,
+                    Definition* type,
+                    Register dest,
+                    Register left,
+                    Register right)
+                : opcode(opcode),
+                unaryOp(unaryOp),
+                binaryOp(binaryOp),
+                type(type),
+                dest(dest),
+                left(left),
+                right(right) {}
+
+                Opcode opcode;
+                UnaryOperatorKind unaryOp;
+                BinaryOperatorKind binaryOp;
+                Definition* type;
+                Register dest;
+                Register left;
+                Register right;
+            };
+
+            Register addRegister(Value value);
+            bool applyUnaryOperator(UnaryOperatorKind op, const Value& operand, Value& result) const;
+            bool applyBinaryOperator(BinaryOperatorKind op, const Value& left, const Value& right, Value& result) const;
+            bool applyCast(Definition* type, const Value& operand, Value& result) const;
+
+            std::size_t inputCount;
+            Definition* boolType;
+            Definition* u8Type;
+
+            std::vector<Instruction> instructions;
+            std::vector<Value> registers;
+
+            Register result;
+            SourceLocation resultLocation;
+    };
+}
+
+#endif
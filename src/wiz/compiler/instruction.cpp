@@ -10,7 +10,10 @@
 namespace wiz {
     template <>
     void FwdDeleter<InstructionOperand>::operator()(const InstructionOperand* ptr) {
-        delete ptr;
+        if (ptr != nullptr) {
+            ptr->~InstructionOperand();
+            Arena::deallocate(ptr, sizeof(InstructionOperand));
+        }
     }
 
     FwdUniquePtr<InstructionOperand> InstructionOperand::clone() const {
@@ -31,7 +34,7 @@ namespace wiz {
             case VariantType::typeIndexOf<Boolean>(): {
                 const auto& boolean = variant.get<Boolean>();
                 return makeFwdUnique<InstructionOperand>(InstructionOperand::Boolean(
-                    boolean.value));
+                    boolean.value, boolean.placeholder));
             }
             case VariantType::typeIndexOf<Dereference>(): {
                 const auto& dereference = variant.get<Dereference>();
@@ -170,6 +173,41 @@ namespace wiz {
         }
     }
 
+    bool InstructionOperand::hasPlaceholder() const {
+        switch (variant.index()) {
+            case VariantType::typeIndexOf<BitIndex>(): {
+                const auto& bitIndex = variant.get<BitIndex>();
+                return bitIndex.operand->hasPlaceholder() || bitIndex.subscript->hasPlaceholder();
+            }
+            case VariantType::typeIndexOf<Binary>(): {
+                const auto& bin = variant.get<Binary>();
+                return bin.left->hasPlaceholder() || bin.right->hasPlaceholder();
+            }
+            case VariantType::typeIndexOf<Boolean>(): {
+                const auto& boolean = variant.get<Boolean>();
+                return boolean.placeholder;
+            }
+            case VariantType::typeIndexOf<Dereference>(): {
+                const auto& dereference = variant.get<Dereference>();
+                return dereference.operand->hasPlaceholder();
+            }
+            case VariantType::typeIndexOf<Index>(): {
+                const auto& index = variant.get<Index>();
+                return index.operand->hasPlaceholder() || index.subscript->hasPlaceholder();
+            }
+            case VariantType::typeIndexOf<Integer>(): {
+                const auto& integer = variant.get<Integer>();
+                return integer.placeholder;
+            }
+            case VariantType::typeIndexOf<Register>(): return false;
+            case VariantType::typeIndexOf<Unary>(): {
+                const auto& un = variant.get<Unary>();
+                return un.operand->hasPlaceholder();
+            }
+            default: std::abort(); return false;
+        }
+    }
+
     std::string InstructionOperand::toString() const {
         switch (variant.index()) {
             case VariantType::typeIndexOf<BitIndex>(): {
@@ -550,7 +588,7 @@ namespace wiz {
         }
     }
 
-    bool InstructionOperandPattern::extract(const InstructionOperand& operand, std::vector<const InstructionOperand*>& captureList) const {
+    bool InstructionOperandPattern::extract(const InstructionOperand& operand, InstructionCaptureLists::List& captureList) const {
         switch (variant.index()) {
             case VariantType::typeIndexOf<BitIndex>(): {
                 const auto& bitIndexPattern = variant.get<BitIndex>();
@@ -564,8 +602,7 @@ namespace wiz {
             case VariantType::typeIndexOf<Capture>(): {
                 const auto& capturePattern = variant.get<Capture>();
                 if (capturePattern.operandPattern->matches(operand)) {
-                    captureList.push_back(&operand);
-                    return true;
+                    return captureList.push_back(&operand);
                 }
                 return false;
             }
@@ -787,7 +824,7 @@ namespace wiz {
         return true;
     }
 
-    bool InstructionSignature::matches(std::uint32_t modeFlags, const std::vector<InstructionOperandRoot>& operandRoots) const {
+    bool InstructionSignature::matches(std::uint32_t modeFlags, ArrayView<InstructionOperandRoot> operandRoots) const {
         if (requiredModeFlags != 0 && (requiredModeFlags & modeFlags) != requiredModeFlags) {
             return false;
         }
@@ -802,13 +839,10 @@ namespace wiz {
         return true;
     }
 
-    bool InstructionSignature::extract(const std::vector<InstructionOperandRoot>& operandRoots, std::vector<std::vector<const InstructionOperand*>>& captureLists) const {
+    bool InstructionSignature::extract(ArrayView<InstructionOperandRoot> operandRoots, InstructionCaptureLists& captureLists) const {
         const auto operandRootsCount = operandRoots.size();
-        if (captureLists.size() < operandRootsCount) {
-            captureLists.resize(operandRootsCount);
-        }
-        for (auto& captureList : captureLists) {
-            captureList.clear();
+        if (!captureLists.reset(operandRootsCount)) {
+            return false;
         }
         for (std::size_t i = 0; i != operandRootsCount; ++i) {
             const auto operandPattern = operandPatterns[i];
@@ -825,6 +859,224 @@ namespace wiz {
         return true;
     }
 
+    bool InstructionSignature::extract(ArrayView<const InstructionOperand*> operands, InstructionCaptureLists& captureLists) const {
+        const auto operandsCount = operands.size();
+        if (!captureLists.reset(operandsCount)) {
+            return false;
+        }
+        for (std::size_t i = 0; i != operandsCount; ++i) {
+            const auto operandPattern = operandPatterns[i];
+            const auto operand = operands[i];
+            auto& captureList = captureLists[i];
+
+            if (!operandPattern->extract(*operand, captureList)) {
+                return false;
+            }
+            if (captureList.size() == 0) {
+                captureList.push_back(operand);
+            }
+        }
+        return true;
+    }
+
+
+
+    InstructionSelectionTree::InstructionSelectionTree() {}
+
+    InstructionSelectionTree::InstructionSelectionTree(const std::vector<const Instruction*>& candidates) {
+        std::size_t maxOperandCount = 0;
+        for (const auto candidate : candidates) {
+            maxOperandCount = std::max(maxOperandCount, candidate->signature.operandPatterns.size());
+        }
+
+        rootsByOperandCount.resize(candidates.empty() ? 0 : maxOperandCount + 1, SIZE_MAX);
+
+        std::vector<const Instruction*> subset;
+        for (std::size_t operandCount = 0; operandCount != rootsByOperandCount.size(); ++operandCount) {
+            subset.clear();
+            for (const auto candidate : candidates) {
+                if (candidate->signature.operandPatterns.size() == operandCount) {
+                    subset.push_back(candidate);
+                }
+            }
+
+            if (!subset.empty()) {
+                rootsByOperandCount[operandCount] = buildNode(subset, 0, operandCount);
+            }
+        }
+    }
+
+    const Instruction* InstructionSelectionTree::findFirstMatch(std::uint32_t modeFlags, ArrayView<InstructionOperandRoot> operandRoots) const {
+        const auto operandCount = operandRoots.size();
+        if (operandCount >= rootsByOperandCount.size() || rootsByOperandCount[operandCount] == SIZE_MAX) {
+            return nullptr;
+        }
+
+        auto node = &nodes[rootsByOperandCount[operandCount]];
+        while (node->operandIndex != SIZE_MAX) {
+            const auto key = getOperandKey(*node, *operandRoots[node->operandIndex].operand);
+            const auto& edges = node->edges;
+            const auto match = std::lower_bound(edges.begin(), edges.end(), key, [](const Edge& edge, const Key& key) { return edge.key < key; });
+            if (match == edges.end() || match->key != key) {
+                return nullptr;
+            }
+
+            node = &nodes[match->childIndex];
+        }
+
+        for (const auto candidate : node->candidates) {
+            if (candidate->signature.matches(modeFlags, operandRoots)) {
+                return candidate;
+            }
+        }
+        return nullptr;
+    }
+
+    std::size_t InstructionSelectionTree::buildNode(const std::vector<const Instruction*>& candidates, std::size_t operandIndex, std::size_t operandCount) {
+        const auto nodeIndex = nodes.size();
+        nodes.push_back(Node());
+
+        if (operandIndex == operandCount || candidates.size() <= 1) {
+            nodes[nodeIndex].candidates = candidates;
+            return nodeIndex;
+        }
+
+        Node node;
+        node.operandIndex = operandIndex;
+
+        for (const auto candidate : candidates) {
+            auto pattern = candidate->signature.operandPatterns[operandIndex];
+            while (const auto capturePattern = pattern->variant.tryGet<InstructionOperandPattern::Capture>()) {
+                pattern = capturePattern->operandPattern.get();
+            }
+
+            if (const auto atLeastPattern = pattern->variant.tryGet<InstructionOperandPattern::IntegerAtLeast>()) {
+                node.integerBounds.push_back(atLeastPattern->min);
+            } else if (const auto rangePattern = pattern->variant.tryGet<InstructionOperandPattern::IntegerRange>()) {
+                node.integerBounds.push_back(rangePattern->min);
+                node.integerBounds.push_back(rangePattern->max + Int128(1));
+            }
+        }
+
+        std::sort(node.integerBounds.begin(), node.integerBounds.end());
+        node.integerBounds.erase(std::unique(node.integerBounds.begin(), node.integerBounds.end()), node.integerBounds.end());
+
+        std::vector<std::vector<Key>> candidateKeys(candidates.size());
+        std::vector<Key> allKeys;
+        for (std::size_t i = 0; i != candidates.size(); ++i) {
+            getPatternKeys(node, *candidates[i]->signature.operandPatterns[operandIndex], candidateKeys[i]);
+            allKeys.insert(allKeys.end(), candidateKeys[i].begin(), candidateKeys[i].end());
+        }
+
+        std::sort(allKeys.begin(), allKeys.end());
+        allKeys.erase(std::unique(allKeys.begin(), allKeys.end()), allKeys.end());
+
+        std::vector<const Instruction*> subset;
+        for (const auto& key : allKeys) {
+            subset.clear();
+            for (std::size_t i = 0; i != candidates.size(); ++i) {
+                const auto& keys = candidateKeys[i];
+                if (std::find(keys.begin(), keys.end(), key) != keys.end()) {
+                    subset.push_back(candidates[i]);
+                }
+            }
+
+            const auto childIndex = buildNode(subset, operandIndex + 1, operandCount);
+            node.edges.push_back(Edge(key, childIndex));
+        }
+
+        nodes[nodeIndex] = std::move(node);
+        return nodeIndex;
+    }
+
+    InstructionSelectionTree::Key InstructionSelectionTree::getOperandKey(const Node& node, const InstructionOperand& operand) const {
+        const auto& variant = operand.variant;
+        const auto kind = variant.index();
+        switch (kind) {
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::BitIndex>(): return Key(kind, 0);
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Binary>(): return Key(kind, 0);
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Boolean>(): {
+                const auto& boolean = variant.get<InstructionOperand::Boolean>();
+                return Key(kind, boolean.value ? 1 : 0);
+            }
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Dereference>(): {
+                const auto& dereference = variant.get<InstructionOperand::Dereference>();
+                return Key(kind, (dereference.size << 1) | (dereference.far ? 1 : 0));
+            }
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Index>(): {
+                const auto& index = variant.get<InstructionOperand::Index>();
+                return Key(kind, (index.size << 1) | (index.far ? 1 : 0));
+            }
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Integer>(): {
+                const auto& integer = variant.get<InstructionOperand::Integer>();
+                const auto& bounds = node.integerBounds;
+                return Key(kind, static_cast<std::uintptr_t>(std::upper_bound(bounds.begin(), bounds.end(), integer.value) - bounds.begin()));
+            }
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Register>(): {
+                const auto& reg = variant.get<InstructionOperand::Register>();
+                return Key(kind, reinterpret_cast<std::uintptr_t>(reg.definition));
+            }
+            case InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Unary>(): {
+                const auto& un = variant.get<InstructionOperand::Unary>();
+                return Key(kind, static_cast<std::uintptr_t>(un.kind));
+            }
+            default: std::abort(); return Key();
+        }
+    }
+
+    void InstructionSelectionTree::getPatternKeys(const Node& node, const InstructionOperandPattern& pattern, std::vector<Key>& keys) const {
+        const auto& variant = pattern.variant;
+        switch (variant.index()) {
+            case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::BitIndex>(): {
+                keys.push_back(Key(InstructionOperand::VariantType::typeIndexOf<InstructionOperand::BitIndex>(), 0));
+                break;
+            }
+            case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::Boolean>(): {
+                const auto& booleanPattern = variant.get<InstructionOperandPattern::Boolean>();
+                keys.push_back(Key(InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Boolean>(), booleanPattern.value ? 1 : 0));
+                break;
+            }
+            case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::Capture>(): {
+                const auto& capturePattern = variant.get<InstructionOperandPattern::Capture>();
+                getPatternKeys(node, *capturePattern.operandPattern, keys);
+                break;
+            }
+            case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::Dereference>(): {
+                const auto& dereferencePattern = variant.get<InstructionOperandPattern::Dereference>();
+                keys.push_back(Key(InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Dereference>(), (dereferencePattern.size << 1) | (dereferencePattern.far ? 1 : 0)));
+                break;
+            }
+            case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::Index>(): {
+                const auto& indexPattern = variant.get<InstructionOperandPattern::Index>();
+                keys.push_back(Key(InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Index>(), (indexPattern.size << 1) | (indexPattern.far ? 1 : 0)));
+                break;
+            }
+            case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::IntegerAtLeast>():
+            case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::IntegerRange>(): {
+                // Bucket 0 holds values below every bound, which no pattern at this node can match.
+                // Every other bucket is represented by its lower bound, since all values in a bucket match the same patterns.
+                const auto& bounds = node.integerBounds;
+                for (std::size_t i = 0; i != bounds.size(); ++i) {
+                    if (pattern.matches(InstructionOperand(InstructionOperand::Integer(bounds[i])))) {
+                        keys.push_back(Key(InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Integer>(), static_cast<std::uintptr_t>(i + 1)));
+                    }
+                }
+                break;
+            }
+            case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::Register>(): {
+                const auto& registerPattern = variant.get<InstructionOperandPattern::Register>();
+                keys.push_back(Key(InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Register>(), reinterpret_cast<std::uintptr_t>(registerPattern.definition)));
+                break;
+            }
+            case InstructionOperandPattern::VariantType::typeIndexOf<InstructionOperandPattern::Unary>(): {
+                const auto& unPattern = variant.get<InstructionOperandPattern::Unary>();
+                keys.push_back(Key(InstructionOperand::VariantType::typeIndexOf<InstructionOperand::Unary>(), static_cast<std::uintptr_t>(unPattern.kind)));
+                break;
+            }
+            default: std::abort(); break;
+        }
+    }
+
 
 
     template<>
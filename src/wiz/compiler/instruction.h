@@ -4,8 +4,11 @@
 #include <cstdint>
 #include <string>
 #include <vector>
+#include <utility>
 #include <type_traits>
 
+#include <wiz/utility/arena.h>
+#include <wiz/utility/macros.h>
 #include <wiz/utility/fwd_unique_ptr.h>
 #include <wiz/utility/array_view.h>
 #include <wiz/utility/variant.h>
@@ -146,6 +149,7 @@ namespace wiz {
 
         FwdUniquePtr<InstructionOperand> clone() const;
         int compare(const InstructionOperand& other) const;
+        bool hasPlaceholder() const;
         std::string toString() const;
 
         bool operator ==(const InstructionOperand& other) const {
@@ -186,6 +190,86 @@ namespace wiz {
         VariantType variant;
     };
 
+    // Operands are made for every instruction in the IR, so like expressions, their storage comes from the current arena.
+    template <>
+    struct FwdAllocator<InstructionOperand> : ArenaFwdAllocator<InstructionOperand> {};
+
+    // The operands captured from each operand root of an instruction, which are handed to its encoding.
+    // Has a fixed capacity, so that matching and encoding an instruction never allocates.
+    class InstructionCaptureLists {
+        public:
+            // Enough for every instruction signature defined by the platforms, with room to spare.
+            enum : std::size_t {
+                MaxOperandRoots = 8,
+                MaxCaptures = 4,
+            };
+
+            class List {
+                public:
+                    List()
+                    : items(),
+                    length(0) {}
+
+                    WIZ_FORCE_INLINE std::size_t size() const {
+                        return length;
+                    }
+
+                    WIZ_FORCE_INLINE const InstructionOperand* operator [](std::size_t index) const {
+                        return items[index];
+                    }
+
+                    WIZ_FORCE_INLINE bool push_back(const InstructionOperand* operand) {
+                        if (length == MaxCaptures) {
+                            return false;
+                        }
+                        items[length++] = operand;
+                        return true;
+                    }
+
+                    WIZ_FORCE_INLINE void clear() {
+                        length = 0;
+                    }
+
+                private:
+                    const InstructionOperand* items[MaxCaptures];
+                    std::size_t length;
+            };
+
+            InstructionCaptureLists()
+            : length(0) {}
+
+            WIZ_FORCE_INLINE std::size_t size() const {
+                return length;
+            }
+
+            WIZ_FORCE_INLINE const List& operator [](std::size_t index) const {
+                return lists[index];
+            }
+
+            WIZ_FORCE_INLINE List& operator [](std::size_t index) {
+                return lists[index];
+            }
+
+            // Empties the lists, and sets how many there are. Returns false if there are more operands than there is room for.
+            bool reset(std::size_t count) {
+                if (count > MaxOperandRoots) {
+                    return false;
+                }
+                for (std::size_t i = 0; i != count; ++i) {
+                    lists[i].clear();
+                }
+                length = count;
+                return true;
+            }
+
+        private:
+            InstructionCaptureLists(const InstructionCaptureLists&) = delete;
+            InstructionCaptureLists& operator=(const InstructionCaptureLists&) = delete;
+
+            List lists[MaxOperandRoots];
+            std::size_t length;
+    };
+
     struct InstructionOperandPattern {
         struct BitIndex {
             BitIndex(
@@ -300,7 +384,7 @@ namespace wiz {
         int compare(const InstructionOperandPattern& other) const;
         bool isSubsetOf(const InstructionOperandPattern& other) const;
         bool matches(const InstructionOperand& operand) const;
-        bool extract(const InstructionOperand& operand, std::vector<const InstructionOperand*>& captureList) const; 
+        bool extract(const InstructionOperand& operand, InstructionCaptureLists::List& captureList) const;
         std::string toString() const;
 
         bool operator ==(const InstructionOperandPattern& other) const {
@@ -344,19 +428,24 @@ namespace wiz {
     struct InstructionOperandRoot {
         InstructionOperandRoot()
         : expression(nullptr),
-        operand(nullptr) {}
+        operand(nullptr),
+        linkTimeDependent(false) {}
 
         InstructionOperandRoot(
             const Expression* expression,
             FwdUniquePtr<const InstructionOperand> operand)
         : expression(expression),
-        operand(std::move(operand)) {}
+        operand(std::move(operand)),
+        linkTimeDependent(expression != nullptr && this->operand != nullptr && this->operand->hasPlaceholder()) {}
 
         InstructionOperandRoot(InstructionOperandRoot&&) = default;
         InstructionOperandRoot(const InstructionOperandRoot&) = delete;
 
         const Expression* expression = nullptr;
         FwdUniquePtr<const InstructionOperand> operand;
+        // Whether the operand contains placeholders for values that are unknown until link-time (eg. label addresses),
+        // meaning the expression must be reduced again when the instruction is written.
+        bool linkTimeDependent;
     };
 
     struct InstructionOptions {
@@ -373,18 +462,77 @@ namespace wiz {
         std::vector<Definition*> affectedFlags;
     };
 
-    using InstructionSizeFunc = std::size_t (*)(const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists);
-    using InstructionWriteFunc = bool (*)(Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location);
+    // The bytes of an instruction, encoded in place into the space that its bank reserved for it.
+    // Has just enough of the std::vector interface for the encodings to append to it.
+    // Writing more bytes than there is room for doesn't touch memory past the end, but marks the buffer as overflowed.
+    class InstructionBuffer {
+        public:
+            InstructionBuffer(
+                std::uint8_t* data,
+                std::size_t capacity)
+            : data(data),
+            capacity(capacity),
+            length(0),
+            overflowed(false) {}
+
+            WIZ_FORCE_INLINE std::size_t size() const {
+                return length;
+            }
+
+            WIZ_FORCE_INLINE bool hasOverflowed() const {
+                return overflowed;
+            }
+
+            WIZ_FORCE_INLINE std::size_t end() const {
+                return length;
+            }
+
+            WIZ_FORCE_INLINE std::uint8_t& operator [](std::size_t index) {
+                return data[index];
+            }
+
+            WIZ_FORCE_INLINE void push_back(std::uint8_t value) {
+                if (length == capacity) {
+                    overflowed = true;
+                    return;
+                }
+                data[length++] = value;
+            }
+
+            // Only appends, the position is accepted to match the std::vector call it stands in for.
+            template <typename Iterator>
+            void insert(std::size_t position, Iterator first, Iterator last) {
+                static_cast<void>(position);
+                for (; first != last; ++first) {
+                    push_back(*first);
+                }
+            }
+
+        private:
+            std::uint8_t* data;
+            std::size_t capacity;
+            std::size_t length;
+            bool overflowed;
+    };
+
+    using InstructionSizeFunc = std::size_t (*)(const InstructionOptions& options, const InstructionCaptureLists& captureLists);
+    using InstructionWriteFunc = bool (*)(Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location);
+    // Returns whether the operands are within reach of the encoding, if it was written at the current address of the bank (eg. pc-relative offsets).
+    using InstructionRangeFunc = bool (*)(const Bank* bank, const InstructionOptions& options, const InstructionCaptureLists& captureLists);
 
     struct InstructionEncoding {
         InstructionEncoding(
             InstructionSizeFunc calculateSize,
-            InstructionWriteFunc write)
+            InstructionWriteFunc write,
+            InstructionRangeFunc checkRange = nullptr)
         : calculateSize(calculateSize),
-        write(write) {}
+        write(write),
+        checkRange(checkRange) {}
         
         InstructionSizeFunc calculateSize;
         InstructionWriteFunc write;
+        // Optional. Used by branch relaxation to find short branches that must be promoted to a longer form.
+        InstructionRangeFunc checkRange;
     };
 
     struct InstructionType {
@@ -467,8 +615,9 @@ namespace wiz {
 
         int compare(const InstructionSignature& other) const;
         bool isSubsetOf(const InstructionSignature& other) const;
-        bool matches(std::uint32_t modeFlags, const std::vector<InstructionOperandRoot>& operandRoots) const;
-        bool extract(const std::vector<InstructionOperandRoot>& operandRoots, std::vector<std::vector<const InstructionOperand*>>& captureLists) const;
+        bool matches(std::uint32_t modeFlags, ArrayView<InstructionOperandRoot> operandRoots) const;
+        bool extract(ArrayView<InstructionOperandRoot> operandRoots, InstructionCaptureLists& captureLists) const;
+        bool extract(ArrayView<const InstructionOperand*> operands, InstructionCaptureLists& captureLists) const;
     };
 
     struct Instruction {
@@ -484,6 +633,54 @@ namespace wiz {
         const InstructionEncoding* encoding;
         InstructionOptions options;
     };
+
+    // A decision tree that narrows an ordered list of candidate instructions down by the top-level shape of each operand
+    // (operand kind, register, integer range, etc), so that only a few candidates need to be matched fully.
+    // Finds the same instruction as checking each candidate's signature in order, and returning the first match.
+    class InstructionSelectionTree {
+        public:
+            InstructionSelectionTree();
+            explicit InstructionSelectionTree(const std::vector<const Instruction*>& candidates);
+
+            const Instruction* findFirstMatch(std::uint32_t modeFlags, ArrayView<InstructionOperandRoot> operandRoots) const;
+
+        private:
+            using Key = std::pair<std::size_t, std::uintptr_t>;
+
+            struct Edge {
+                Edge(
+                    Key key,
+                    std::size_t childIndex)
+                : key(key),
+                childIndex(childIndex) {}
+
+                Key key;
+                std::size_t childIndex;
+            };
+
+            struct Node {
+                Node()
+                : operandIndex(SIZE_MAX) {}
+
+                // The operand examined by this node, or SIZE_MAX if this node is a leaf.
+                std::size_t operandIndex;
+                // Sorted list of boundaries used to bucket integer operands. Each bucket [bounds[i - 1], bounds[i]) is either
+                // fully inside or fully outside the range of every integer pattern at this node.
+                std::vector<Int128> integerBounds;
+                // Sorted by key.
+                std::vector<Edge> edges;
+                // The remaining candidates, in their original order. Only used by leaf nodes.
+                std::vector<const Instruction*> candidates;
+            };
+
+            std::size_t buildNode(const std::vector<const Instruction*>& candidates, std::size_t operandIndex, std::size_t operandCount);
+            Key getOperandKey(const Node& node, const InstructionOperand& operand) const;
+            void getPatternKeys(const Node& node, const InstructionOperandPattern& pattern, std::vector<Key>& keys) const;
+
+            std::vector<Node> nodes;
+            // Root node index for each operand count, or SIZE_MAX if no candidate takes that many operands.
+            std::vector<std::size_t> rootsByOperandCount;
+    };
 }
 
 namespace std {
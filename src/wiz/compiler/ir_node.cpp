@@ -1,9 +1,81 @@
-#include <wiz/compiler/ir_node.h>
+#include <utility>
 
+#include <wiz/compiler/ir_node.h>
 
 namespace wiz {
-    template <>
-    void FwdDeleter<IrNode>::operator()(const IrNode* ptr) {
-        delete ptr;
+    IrNodeList::IrNodeList()
+    : operandOffsets(1, 0) {}
+
+    IrNodeList::~IrNodeList() {}
+
+    void IrNodeList::addPushRelocation(Bank* bank, Optional<std::size_t> address, SourceLocation location) {
+        addNode(IrNodeKind::PushRelocation, relocations.size(), location);
+        relocations.push_back(Relocation(bank, address));
+    }
+
+    void IrNodeList::addPopRelocation(SourceLocation location) {
+        addNode(IrNodeKind::PopRelocation, 0, location);
+    }
+
+    void IrNodeList::addLabel(Definition* definition, SourceLocation location) {
+        addNode(IrNodeKind::Label, definitions.size(), location);
+        definitions.push_back(definition);
+    }
+
+    void IrNodeList::addCode(const Instruction* instruction, std::uint32_t flags, std::vector<InstructionOperandRoot> roots, SourceLocation location) {
+        addNode(IrNodeKind::Code, instructions.size(), location);
+        instructions.push_back(instruction);
+        modeFlags.push_back(flags);
+        for (auto& root : roots) {
+            operandRoots.push_back(std::move(root));
+        }
+        operandOffsets.push_back(operandRoots.size());
+    }
+
+    void IrNodeList::addVar(Definition* definition, SourceLocation location) {
+        addNode(IrNodeKind::Var, definitions.size(), location);
+        definitions.push_back(definition);
+    }
+
+    const Instruction* IrNodeList::replaceInstruction(std::size_t index, const Instruction* instruction) {
+        std::swap(instructions[payloads[index]], instruction);
+        return instruction;
+    }
+
+    FwdUniquePtr<const InstructionOperand> IrNodeList::replaceOperand(std::size_t index, std::size_t operandIndex, FwdUniquePtr<const InstructionOperand> operand) {
+        auto& root = operandRoots[operandOffsets[payloads[index]] + operandIndex];
+        std::swap(root.operand, operand);
+        root.linkTimeDependent = root.expression != nullptr && root.operand->hasPlaceholder();
+        return operand;
+    }
+
+    void IrNodeList::remove(const std::vector<std::size_t>& indices) {
+        if (indices.empty()) {
+            return;
+        }
+
+        auto dest = indices[0];
+        auto next = indices.begin();
+        for (auto source = dest; source != kinds.size(); ++source) {
+            if (next != indices.end() && *next == source) {
+                ++next;
+                continue;
+            }
+
+            kinds[dest] = kinds[source];
+            locations[dest] = locations[source];
+            payloads[dest] = payloads[source];
+            ++dest;
+        }
+
+        kinds.erase(kinds.begin() + dest, kinds.end());
+        locations.erase(locations.begin() + dest, locations.end());
+        payloads.erase(payloads.begin() + dest, payloads.end());
+    }
+
+    void IrNodeList::addNode(IrNodeKind kind, std::size_t payload, SourceLocation location) {
+        kinds.push_back(kind);
+        locations.push_back(location);
+        payloads.push_back(payload);
     }
-}
\ No newline at end of file
+}
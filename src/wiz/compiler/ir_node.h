@@ -1,79 +1,127 @@
 #ifndef WIZ_COMPILER_IR_NODE_H
 #define WIZ_COMPILER_IR_NODE_H
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
-#include <type_traits>
 
-#include <wiz/ast/expression.h>
 #include <wiz/compiler/instruction.h>
-#include <wiz/utility/variant.h>
+#include <wiz/utility/macros.h>
 #include <wiz/utility/optional.h>
 #include <wiz/utility/fwd_unique_ptr.h>
+#include <wiz/utility/array_view.h>
+#include <wiz/utility/source_location.h>
 
 namespace wiz {
+    class Bank;
     struct Definition;
-    class SymbolTable;
-
-    struct IrNode {
-        struct PushRelocation {
-            PushRelocation(
-                Bank* bank,
-                Optional<std::size_t> address)
-            : bank(bank),
-            address(address) {}
-
-            Bank* bank;
-            Optional<std::size_t> address;
-        };
-
-        struct PopRelocation {};
-
-        struct Label {
-            Label(
-                Definition* definition)
-            : definition(definition) {}
-
-            Definition* definition;
-        };
-
-        struct Code {
-            Code(
-                const Instruction* instruction,
-                std::vector<InstructionOperandRoot> operandRoots)
-            : instruction(instruction),
-            operandRoots(std::move(operandRoots)) {}
-
-            const Instruction* instruction;
+
+    enum class IrNodeKind : std::uint8_t {
+        PushRelocation,
+        PopRelocation,
+        Label,
+        Code,
+        Var,
+    };
+
+    // The IR of a program, kept in flat arrays so that code generation can stream through it from front to back.
+    // Each node has a kind, a location, and the index of its payload in the array for its kind:
+    // - Code: the instruction, and a range of operand roots. The operand roots of all code nodes are stored back-to-back.
+    // - Label, Var: the definition.
+    // - PushRelocation: the bank and address to relocate to.
+    class IrNodeList {
+        public:
+            struct Relocation {
+                Relocation(
+                    Bank* bank,
+                    Optional<std::size_t> address)
+                : bank(bank),
+                address(address) {}
+
+                Bank* bank;
+                Optional<std::size_t> address;
+            };
+
+            IrNodeList();
+            ~IrNodeList();
+
+            void addPushRelocation(Bank* bank, Optional<std::size_t> address, SourceLocation location);
+            void addPopRelocation(SourceLocation location);
+            void addLabel(Definition* definition, SourceLocation location);
+            void addCode(const Instruction* instruction, std::uint32_t modeFlags, std::vector<InstructionOperandRoot> operandRoots, SourceLocation location);
+            void addVar(Definition* definition, SourceLocation location);
+
+            // Changes the instruction of a code node, and returns its previous one.
+            // Used by branch relaxation, which promotes a branch by changing the distance hint given to instruction selection.
+            const Instruction* replaceInstruction(std::size_t index, const Instruction* instruction);
+            FwdUniquePtr<const InstructionOperand> replaceOperand(std::size_t index, std::size_t operandIndex, FwdUniquePtr<const InstructionOperand> operand);
+
+            // Removes the nodes at the given indices, which must be in ascending order, in a single pass.
+            // Payloads stay where they are, so getOwner() is unaffected.
+            void remove(const std::vector<std::size_t>& indices);
+
+            WIZ_FORCE_INLINE std::size_t size() const {
+                return kinds.size();
+            }
+
+            WIZ_FORCE_INLINE IrNodeKind getKind(std::size_t index) const {
+                return kinds[index];
+            }
+
+            WIZ_FORCE_INLINE const SourceLocation& getLocation(std::size_t index) const {
+                return locations[index];
+            }
+
+            WIZ_FORCE_INLINE const Instruction* getInstruction(std::size_t index) const {
+                return instructions[payloads[index]];
+            }
+
+            // The mode flags that were in effect when the instruction of a code node was selected.
+            WIZ_FORCE_INLINE std::uint32_t getModeFlags(std::size_t index) const {
+                return modeFlags[payloads[index]];
+            }
+
+            WIZ_FORCE_INLINE ArrayView<InstructionOperandRoot> getOperandRoots(std::size_t index) const {
+                const auto payload = payloads[index];
+                const auto offset = operandOffsets[payload];
+                return ArrayView<InstructionOperandRoot>(operandRoots.data() + offset, operandOffsets[payload + 1] - offset);
+            }
+
+            WIZ_FORCE_INLINE Definition* getDefinition(std::size_t index) const {
+                return definitions[payloads[index]];
+            }
+
+            WIZ_FORCE_INLINE const Relocation& getRelocation(std::size_t index) const {
+                return relocations[payloads[index]];
+            }
+
+            // Identifies a code or var node to the banks that it reserves space in.
+            // Unlike the node index, this doesn't change when earlier nodes are removed.
+            WIZ_FORCE_INLINE const void* getOwner(std::size_t index) const {
+                if (kinds[index] == IrNodeKind::Code) {
+                    return &instructions[payloads[index]];
+                }
+                return &definitions[payloads[index]];
+            }
+
+        private:
+            IrNodeList(const IrNodeList&) = delete;
+            IrNodeList& operator=(const IrNodeList&) = delete;
+
+            void addNode(IrNodeKind kind, std::size_t payload, SourceLocation location);
+
+            std::vector<IrNodeKind> kinds;
+            std::vector<SourceLocation> locations;
+            std::vector<std::size_t> payloads;
+
+            std::vector<const Instruction*> instructions;
+            std::vector<std::uint32_t> modeFlags;
+            // Where the operand roots of each code node start, followed by the end of the last one.
+            std::vector<std::size_t> operandOffsets;
             std::vector<InstructionOperandRoot> operandRoots;
-        };
-
-        struct Var {
-            Var(
-                Definition* definition)
-            : definition(definition) {}
-
-            Definition* definition;
-        };
-
-        template <typename T>
-        IrNode(
-            T&& variant,
-            SourceLocation sourceLocation)
-        : variant(std::forward<T>(variant)),
-        location(sourceLocation) {}
-
-        using VariantType = Variant<
-            PushRelocation,
-            PopRelocation,
-            Label,
-            Code,
-            Var
-        >;
-
-        VariantType variant;
-        SourceLocation location;
+            std::vector<Definition*> definitions;
+            std::vector<Relocation> relocations;
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -14,14 +14,24 @@ namespace wiz {
         return std::string(buffer);
     }
 
+    std::size_t SymbolTable::lookupGeneration = 0;
+
     SymbolTable::SymbolTable()
-    : parent(nullptr) {}
+    : parent(nullptr),
+    hasDependents(false),
+    cachedLookupGeneration(lookupGeneration) {}
 
     SymbolTable::SymbolTable(
         SymbolTable* parent,
         StringView namespaceName)
     : parent(parent),
-    namespaceName(namespaceName) {}
+    namespaceName(namespaceName),
+    hasDependents(false),
+    cachedLookupGeneration(lookupGeneration) {
+        if (parent != nullptr) {
+            parent->hasDependents = true;
+        }
+    }
 
     SymbolTable::~SymbolTable() {}
 
@@ -74,6 +84,7 @@ namespace wiz {
             def->parentScope = this;
 
             auto result = def.get();
+            invalidateLookups(def->name);
             namesToDefinitions[def->name] = std::move(def);
             return result;
         }
@@ -85,6 +96,8 @@ namespace wiz {
         }
         if (std::find(imports.begin(), imports.end(), import) == imports.end()) {
             imports.push_back(import);
+            import->hasDependents = true;
+            invalidateLookups(StringView());
             return true;
         }
         return false;
@@ -117,30 +130,53 @@ namespace wiz {
         return nullptr;
     }
 
-    void SymbolTable::findImportedMemberDefinitions(StringView name, std::set<Definition*>& results) const {
+    void SymbolTable::findImportedMemberDefinitions(StringView name, DefinitionList& results) const {
         for (const auto import : imports) {
             if (const auto result = import->findLocalMemberDefinition(name)) {
                 if (std::find(results.begin(), results.end(), result) == results.end()) {
-                    results.insert(result);
+                    results.push_back(result);
                 }
             }
         }
     }
 
-    void SymbolTable::findMemberDefinitions(StringView name, std::set<Definition*>& results) const {
-        findImportedMemberDefinitions(name, results);
+    void SymbolTable::findMemberDefinitions(StringView name, DefinitionList& results) const {
         if (const auto result = findLocalMemberDefinition(name)) {
             if (std::find(results.begin(), results.end(), result) == results.end()) {
-                results.insert(results.begin(), result);
+                results.push_back(result);
             }
         }
+        findImportedMemberDefinitions(name, results);
     }
 
-    void SymbolTable::findUnqualifiedDefinitions(StringView name, std::set<Definition*>& results) const {
+    const SymbolTable::DefinitionList& SymbolTable::findUnqualifiedDefinitions(StringView name) const {
+        if (cachedLookupGeneration != lookupGeneration) {
+            cachedLookups.clear();
+            cachedLookupGeneration = lookupGeneration;
+        }
+
+        const auto match = cachedLookups.find(name);
+        if (match != cachedLookups.end()) {
+            return match->second;
+        }
+
+        DefinitionList results;
         findMemberDefinitions(name, results);
-        if (results.size() == 0 && parent != nullptr) {
-            parent->findUnqualifiedDefinitions(name, results);
+        if (results.empty() && parent != nullptr) {
+            results = parent->findUnqualifiedDefinitions(name);
         }
+        return cachedLookups.emplace(name, results).first->second;
     }
-}
 
+    void SymbolTable::invalidateLookups(StringView name) {
+        // A scope that nothing else can see only needs to forget its own lookups.
+        // An empty name means every lookup in the scope could have changed.
+        if (hasDependents) {
+            ++lookupGeneration;
+        } else if (name.getLength() == 0) {
+            cachedLookups.clear();
+        } else {
+            cachedLookups.erase(name);
+        }
+    }
+}
@@ -1,13 +1,14 @@
 #ifndef WIZ_COMPILER_SYMBOL_TABLE_H
 #define WIZ_COMPILER_SYMBOL_TABLE_H
 
-#include <set>
 #include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
 
 #include <wiz/utility/fwd_unique_ptr.h>
+#include <wiz/utility/string_pool.h>
+#include <wiz/utility/small_vector.h>
 
 namespace wiz {
     struct Definition;
@@ -15,6 +16,9 @@ namespace wiz {
 
     class SymbolTable {
         public:
+            // Most names resolve to a single definition, so lookups rarely need to allocate.
+            using DefinitionList = SmallVector<Definition*, 2>;
+
             static std::string generateBlockName();
 
             SymbolTable();
@@ -39,15 +43,26 @@ namespace wiz {
             bool addImport(SymbolTable* scope);
             bool addRecursiveImport(SymbolTable* scope);
             Definition* findLocalMemberDefinition(StringView name) const;
-            void findImportedMemberDefinitions(StringView name, std::set<Definition*>& results) const;
-            void findMemberDefinitions(StringView name, std::set<Definition*>& results) const;
-            void findUnqualifiedDefinitions(StringView name, std::set<Definition*>& results) const;
+            void findImportedMemberDefinitions(StringView name, DefinitionList& results) const;
+            void findMemberDefinitions(StringView name, DefinitionList& results) const;
+            // The result is cached, and stays valid until the next definition or import is added to any scope.
+            const DefinitionList& findUnqualifiedDefinitions(StringView name) const;
 
         private:
+            void invalidateLookups(StringView name);
+
+            // Bumped whenever a scope changes in a way that could affect the lookups of other scopes.
+            static std::size_t lookupGeneration;
+
             SymbolTable* parent;
             StringView namespaceName;
             std::vector<SymbolTable*> imports;
-            std::unordered_map<StringView, FwdUniquePtr<Definition>> namesToDefinitions;
+            InternedStringMap<FwdUniquePtr<Definition>> namesToDefinitions;
+
+            // Set once another scope can see into this one, either as a child or through an import.
+            bool hasDependents;
+            mutable std::size_t cachedLookupGeneration;
+            mutable InternedStringMap<DefinitionList> cachedLookups;
     };
 }
 
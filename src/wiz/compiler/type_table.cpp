@@ -0,0 +1,304 @@
+#include <cstdint>
+#include <utility>
+
+#include <wiz/ast/expression.h>
+#include <wiz/ast/type_expression.h>
+#include <wiz/compiler/type_table.h>
+
+namespace wiz {
+    namespace {
+        // Must be a power of two.
+        const std::size_t RecentNodeCount = 1024;
+
+        void combineHash(std::size_t& hash, std::size_t value) {
+            hash ^= value + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+        }
+
+        std::size_t getPointerHash(const void* pointer) {
+            return reinterpret_cast<std::uintptr_t>(pointer);
+        }
+
+        // Locations come from the same interned paths, so comparing them by address is enough.
+        bool isSameLocation(const SourceLocation& left, const SourceLocation& right) {
+            return left.line == right.line
+                && left.displayPath.getData() == right.displayPath.getData()
+                && left.canonicalPath.getData() == right.canonicalPath.getData();
+        }
+
+        bool isInterned(const FwdUniquePtr<const TypeExpression>& typeExpression) {
+            return typeExpression != nullptr && typeExpression->canonical != nullptr;
+        }
+
+        bool isInternable(const TypeExpression* typeExpression) {
+            const auto& variant = typeExpression->variant;
+            switch (variant.index()) {
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Array>(): {
+                    const auto& arrayType = variant.get<TypeExpression::Array>();
+                    return isInterned(arrayType.elementType)
+                        && (arrayType.size == nullptr || arrayType.size->variant.is<Expression::IntegerLiteral>());
+                }
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Function>(): {
+                    const auto& functionType = variant.get<TypeExpression::Function>();
+                    if (!isInterned(functionType.returnType)) {
+                        return false;
+                    }
+                    for (const auto& parameterType : functionType.parameterTypes) {
+                        if (!isInterned(parameterType)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Pointer>(): {
+                    return isInterned(variant.get<TypeExpression::Pointer>().elementType);
+                }
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::ResolvedIdentifier>(): return true;
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Tuple>(): {
+                    for (const auto& elementType : variant.get<TypeExpression::Tuple>().elementTypes) {
+                        if (!isInterned(elementType)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+                default: return false;
+            }
+        }
+
+        // Canonical identity: structure only, with operands compared by their canonical type.
+        std::size_t hashCanonicalType(const TypeExpression* typeExpression) {
+            const auto& variant = typeExpression->variant;
+            std::size_t hash = variant.index();
+
+            switch (variant.index()) {
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Array>(): {
+                    const auto& arrayType = variant.get<TypeExpression::Array>();
+                    combineHash(hash, getPointerHash(arrayType.elementType->canonical));
+                    if (arrayType.size != nullptr) {
+                        combineHash(hash, static_cast<std::size_t>(arrayType.size->variant.get<Expression::IntegerLiteral>().value.low));
+                    }
+                    break;
+                }
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Function>(): {
+                    const auto& functionType = variant.get<TypeExpression::Function>();
+                    combineHash(hash, functionType.far ? 1 : 0);
+                    combineHash(hash, getPointerHash(functionType.returnType->canonical));
+                    for (const auto& parameterType : functionType.parameterTypes) {
+                        combineHash(hash, getPointerHash(parameterType->canonical));
+                    }
+                    break;
+                }
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Pointer>(): {
+                    const auto& pointerType = variant.get<TypeExpression::Pointer>();
+                    combineHash(hash, getPointerHash(pointerType.elementType->canonical));
+                    combineHash(hash, pointerType.qualifiers.underlying());
+                    break;
+                }
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::ResolvedIdentifier>(): {
+                    const auto& resolvedIdentifierType = variant.get<TypeExpression::ResolvedIdentifier>();
+                    combineHash(hash, getPointerHash(resolvedIdentifierType.definition));
+                    for (const auto& piece : resolvedIdentifierType.pieces) {
+                        combineHash(hash, getPointerHash(piece.getData()));
+                    }
+                    break;
+                }
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Tuple>(): {
+                    for (const auto& elementType : variant.get<TypeExpression::Tuple>().elementTypes) {
+                        combineHash(hash, getPointerHash(elementType->canonical));
+                    }
+                    break;
+                }
+                default: break;
+            }
+
+            return hash;
+        }
+
+        template <typename T>
+        bool isSameCanonicalTypeList(const std::vector<T>& left, const std::vector<T>& right) {
+            if (left.size() != right.size()) {
+                return false;
+            }
+            for (std::size_t i = 0, size = left.size(); i != size; ++i) {
+                if (left[i]->canonical != right[i]->canonical) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool isSameCanonicalType(const TypeExpression* left, const TypeExpression* right) {
+            const auto& leftVariant = left->variant;
+            const auto& rightVariant = right->variant;
+            if (leftVariant.index() != rightVariant.index()) {
+                return false;
+            }
+
+            switch (leftVariant.index()) {
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Array>(): {
+                    const auto& leftArrayType = leftVariant.get<TypeExpression::Array>();
+                    const auto& rightArrayType = rightVariant.get<TypeExpression::Array>();
+                    if (leftArrayType.elementType->canonical != rightArrayType.elementType->canonical
+                    || (leftArrayType.size == nullptr) != (rightArrayType.size == nullptr)) {
+                        return false;
+                    }
+                    return leftArrayType.size == nullptr
+                        || leftArrayType.size->variant.get<Expression::IntegerLiteral>().value == rightArrayType.size->variant.get<Expression::IntegerLiteral>().value;
+                }
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Function>(): {
+                    const auto& leftFunctionType = leftVariant.get<TypeExpression::Function>();
+                    const auto& rightFunctionType = rightVariant.get<TypeExpression::Function>();
+                    return leftFunctionType.far == rightFunctionType.far
+                        && leftFunctionType.returnType->canonical == rightFunctionType.returnType->canonical
+                        && isSameCanonicalTypeList(leftFunctionType.parameterTypes, rightFunctionType.parameterTypes);
+                }
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Pointer>(): {
+                    const auto& leftPointerType = leftVariant.get<TypeExpression::Pointer>();
+                    const auto& rightPointerType = rightVariant.get<TypeExpression::Pointer>();
+                    return leftPointerType.elementType->canonical == rightPointerType.elementType->canonical
+                        && leftPointerType.qualifiers == rightPointerType.qualifiers;
+                }
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::ResolvedIdentifier>(): {
+                    // Pieces are part of the identity because they are part of the type's name.
+                    const auto& leftResolvedIdentifierType = leftVariant.get<TypeExpression::ResolvedIdentifier>();
+                    const auto& rightResolvedIdentifierType = rightVariant.get<TypeExpression::ResolvedIdentifier>();
+                    if (leftResolvedIdentifierType.definition != rightResolvedIdentifierType.definition
+                    || leftResolvedIdentifierType.pieces.size() != rightResolvedIdentifierType.pieces.size()) {
+                        return false;
+                    }
+                    for (std::size_t i = 0, size = leftResolvedIdentifierType.pieces.size(); i != size; ++i) {
+                        if (leftResolvedIdentifierType.pieces[i].getData() != rightResolvedIdentifierType.pieces[i].getData()
+                        || leftResolvedIdentifierType.pieces[i].getLength() != rightResolvedIdentifierType.pieces[i].getLength()) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Tuple>(): {
+                    return isSameCanonicalTypeList(leftVariant.get<TypeExpression::Tuple>().elementTypes, rightVariant.get<TypeExpression::Tuple>().elementTypes);
+                }
+                default: return false;
+            }
+        }
+
+        // Node identity: the canonical type, plus the locations of the node and everything it owns.
+        // Operands are interned already, so comparing them by address covers their locations.
+        std::size_t hashNode(const TypeExpression* typeExpression, const CanonicalType* canonical) {
+            std::size_t hash = getPointerHash(canonical);
+            combineHash(hash, typeExpression->location.line);
+            combineHash(hash, getPointerHash(typeExpression->location.canonicalPath.getData()));
+            return hash;
+        }
+
+        template <typename T>
+        bool isSameNodeList(const std::vector<T>& left, const std::vector<T>& right) {
+            for (std::size_t i = 0, size = left.size(); i != size; ++i) {
+                if (left[i].get() != right[i].get()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool isSameNode(const TypeExpression* left, const TypeExpression* right) {
+            if (!isSameLocation(left->location, right->location)) {
+                return false;
+            }
+
+            const auto& leftVariant = left->variant;
+            const auto& rightVariant = right->variant;
+            switch (leftVariant.index()) {
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Array>(): {
+                    const auto& leftArrayType = leftVariant.get<TypeExpression::Array>();
+                    const auto& rightArrayType = rightVariant.get<TypeExpression::Array>();
+                    return leftArrayType.elementType.get() == rightArrayType.elementType.get()
+                        && (leftArrayType.size == nullptr || isSameLocation(leftArrayType.size->location, rightArrayType.size->location));
+                }
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Function>(): {
+                    const auto& leftFunctionType = leftVariant.get<TypeExpression::Function>();
+                    const auto& rightFunctionType = rightVariant.get<TypeExpression::Function>();
+                    return leftFunctionType.returnType.get() == rightFunctionType.returnType.get()
+                        && isSameNodeList(leftFunctionType.parameterTypes, rightFunctionType.parameterTypes);
+                }
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Pointer>(): {
+                    return leftVariant.get<TypeExpression::Pointer>().elementType.get() == rightVariant.get<TypeExpression::Pointer>().elementType.get();
+                }
+                case TypeExpression::VariantType::typeIndexOf<TypeExpression::Tuple>(): {
+                    return isSameNodeList(leftVariant.get<TypeExpression::Tuple>().elementTypes, rightVariant.get<TypeExpression::Tuple>().elementTypes);
+                }
+                default: return true;
+            }
+        }
+    }
+
+    TypeTable::TypeTable()
+    : recentNodes(RecentNodeCount, nullptr) {}
+
+    TypeTable::~TypeTable() {
+        // Operand types are always interned before the types that use them, so destroy in reverse.
+        for (auto it = nodesInCreationOrder.rbegin(); it != nodesInCreationOrder.rend(); ++it) {
+            (*it)->~TypeExpression();
+        }
+    }
+
+    FwdUniquePtr<const TypeExpression> TypeTable::intern(FwdUniquePtr<const TypeExpression> typeExpression) {
+        if (typeExpression == nullptr || typeExpression->canonical != nullptr || !isInternable(typeExpression.get())) {
+            return typeExpression;
+        }
+        // Interned nodes live as long as the table, so they can't come from an arena that is about to be reset.
+        if (Arena::getCurrent()->isTemporary()) {
+            return typeExpression;
+        }
+
+        const auto canonical = findOrCreateCanonicalType(typeExpression.get());
+
+        auto& slot = recentNodes[hashNode(typeExpression.get(), canonical) & (RecentNodeCount - 1)];
+        if (slot != nullptr && slot->canonical == canonical && isSameNode(slot, typeExpression.get())) {
+            return FwdUniquePtr<const TypeExpression>(slot);
+        }
+
+        // The type was built by the caller and hasn't been handed out anywhere else yet, so it can still be marked as interned.
+        const auto node = const_cast<TypeExpression*>(typeExpression.release());
+        node->canonical = canonical;
+
+        // Interned types outlive the expression cache, so an array size must not be one of its shared expressions.
+        if (auto arrayType = node->variant.tryGet<TypeExpression::Array>()) {
+            if (arrayType->size != nullptr && arrayType->size->shared) {
+                const auto size = arrayType->size.get();
+                arrayType->size = size->clone(size->location, size->info.hasValue() ? size->info->clone() : Optional<ExpressionInfo>());
+            }
+        }
+
+        if (canonical->representative == nullptr) {
+            canonical->representative = node;
+        }
+        slot = node;
+        nodesInCreationOrder.push_back(node);
+        return FwdUniquePtr<const TypeExpression>(node);
+    }
+
+    std::size_t TypeTable::getNodeCount() const {
+        return nodesInCreationOrder.size();
+    }
+
+    std::size_t TypeTable::getCanonicalTypeCount() const {
+        return canonicalTypes.size();
+    }
+
+    CanonicalType* TypeTable::findOrCreateCanonicalType(const TypeExpression* typeExpression) {
+        const auto hash = hashCanonicalType(typeExpression);
+
+        const auto range = canonicalTypesByHash.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (isSameCanonicalType(it->second->representative, typeExpression)) {
+                return it->second;
+            }
+        }
+
+        // The representative is filled in once the node is actually adopted.
+        canonicalTypes.push_back(std::make_unique<CanonicalType>(nullptr));
+        const auto canonical = canonicalTypes.back().get();
+        canonicalTypesByHash.emplace(hash, canonical);
+        return canonical;
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef WIZ_COMPILER_TYPE_TABLE_H
+#define WIZ_COMPILER_TYPE_TABLE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <unordered_map>
+
+#include <wiz/utility/optional.h>
+#include <wiz/utility/fwd_unique_ptr.h>
+
+namespace wiz {
+    struct TypeExpression;
+
+    // The location-independent identity of a reduced type, shared by every interned node with the same structure.
+    struct CanonicalType {
+        CanonicalType(
+            const TypeExpression* representative)
+        : representative(representative),
+        storageSize(),
+        name(),
+        hasName(false) {}
+
+        const TypeExpression* representative;
+
+        // Filled in by the compiler the first time they're asked for.
+        // Storage size is only kept once it is known, since struct and enum sizes are resolved later than their types.
+        Optional<std::size_t> storageSize;
+        std::string name;
+        bool hasName;
+    };
+
+    // Interns fully-reduced types, so that each one is built once and shared instead of cloned.
+    // Nodes are still distinguished by source location, which diagnostics rely on, but structurally identical
+    // types anywhere in the program share one CanonicalType, so equal canonical pointers mean equal types.
+    // Types containing something that isn't fully reduced (designated storage, `typeof`, unresolved identifiers) are left alone.
+    class TypeTable {
+        public:
+            TypeTable();
+            ~TypeTable();
+
+            // Returns an existing node equal to the given type, or takes ownership of the type if there isn't one yet.
+            // Inside an Arena::TemporaryScope, new nodes are handed back without being interned.
+            FwdUniquePtr<const TypeExpression> intern(FwdUniquePtr<const TypeExpression> typeExpression);
+
+            std::size_t getNodeCount() const;
+            std::size_t getCanonicalTypeCount() const;
+
+        private:
+            TypeTable(const TypeTable&) = delete;
+            TypeTable& operator=(const TypeTable&) = delete;
+
+            CanonicalType* findOrCreateCanonicalType(const TypeExpression* typeExpression);
+
+            std::vector<const TypeExpression*> recentNodes;
+            std::vector<const TypeExpression*> nodesInCreationOrder;
+            std::unordered_multimap<std::size_t, CanonicalType*> canonicalTypesByHash;
+            std::vector<std::unique_ptr<CanonicalType>> canonicalTypes;
+    };
+}
+
+#endif
@@ -1,10 +1,17 @@
 #include <algorithm>
+#include <chrono>
 #include <stdexcept>
 #include <utility>
 #include <cinttypes>
 #include <cstdlib>
 #include <cassert>
 
+#ifndef __EMSCRIPTEN__
+#define WIZ_THREADS
+#include <atomic>
+#include <thread>
+#endif
+
 #include <wiz/ast/expression.h>
 #include <wiz/ast/statement.h>
 #include <wiz/ast/type_expression.h>
@@ -17,6 +24,36 @@
 #include <wiz/utility/source_location.h>
 
 namespace wiz {
+    namespace {
+        void scanSources(const std::vector<ScannedSource*>& sources, std::size_t jobCount) {
+#ifdef WIZ_THREADS
+            std::atomic<std::size_t> nextIndex(0);
+            const auto work = [&]() {
+                for (auto i = nextIndex++; i < sources.size(); i = nextIndex++) {
+                    sources[i]->scan();
+                }
+            };
+
+            std::vector<std::thread> threads;
+            for (std::size_t i = 1, count = std::min(jobCount, sources.size()); i < count; ++i) {
+                threads.emplace_back(work);
+            }
+
+            work();
+
+            for (auto& thread : threads) {
+                thread.join();
+            }
+#else
+            static_cast<void>(jobCount);
+
+            for (const auto source : sources) {
+                source->scan();
+            }
+#endif
+        }
+    }
+
     Parser::Parser(
         StringPool* stringPool,
         ImportManager* importManager,
@@ -25,10 +62,24 @@ namespace wiz {
     importManager(importManager), 
     report(report),
     token(TokenType::None),
-    symbolIndex(0) {}
+    symbolIndex(0),
+    jobCount(1),
+    prescanDuration(0) {}
 
     Parser::~Parser() {}    
 
+    void Parser::setJobCount(std::size_t value) {
+        jobCount = value;
+    }
+
+    std::size_t Parser::getPrescannedModuleCount() const {
+        return scannedSources.size();
+    }
+
+    double Parser::getPrescanDuration() const {
+        return prescanDuration;
+    }
+
     void Parser::nextToken() {
         if (lookaheadBuffer.size() > 0) {
             token = lookaheadBuffer.back();
@@ -150,9 +201,56 @@ namespace wiz {
         return ImportResult::Failed;
     }
 
+    void Parser::prescanModules(StringView canonicalPath, std::unique_ptr<Reader> reader) {
+        // Discover the import graph one level at a time, reading and scanning each level in parallel.
+        // Parsing still happens afterwards, in order, on this thread, so the resulting tree and diagnostics don't change.
+        const auto startTime = std::chrono::steady_clock::now();
+        std::vector<ScannedSource*> sources;
+
+        auto source = std::make_unique<ScannedSource>(std::move(reader), canonicalPath);
+        sources.push_back(source.get());
+        scannedSources[canonicalPath] = std::move(source);
+
+        while (sources.size() != 0) {
+            scanSources(sources, jobCount);
+
+            std::vector<ScannedSource*> importedSources;
+            for (const auto source : sources) {
+                const auto& tokens = source->getTokens();
+
+                for (std::size_t i = 0; i + 1 < tokens.size(); ++i) {
+                    if (tokens[i].keyword == Keyword::Import && tokens[i + 1].type == TokenType::String) {
+                        StringView importedPath;
+                        std::unique_ptr<Reader> importedReader;
+
+                        if (importManager->findModule(source->getCanonicalPath(), tokens[i + 1].text, ImportOptions::of<ImportOptionType::AppendExtension>(), importedPath, importedReader)
+                        && scannedSources.find(importedPath) == scannedSources.end()) {
+                            auto importedSource = std::make_unique<ScannedSource>(std::move(importedReader), importedPath);
+                            importedSources.push_back(importedSource.get());
+                            scannedSources[importedPath] = std::move(importedSource);
+                        }
+                    }
+                }
+            }
+
+            sources = std::move(importedSources);
+        }
+
+        prescanDuration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
     void Parser::pushScanner(StringView displayPath, StringView canonicalPath, std::unique_ptr<Reader> reader) {
         scannerStack.push_back(std::move(scanner));
-        scanner = std::make_unique<Scanner>(std::move(reader), displayPath, canonicalPath, stringPool, report);
+
+        const auto match = scannedSources.find(canonicalPath);
+        if (match == scannedSources.end()) {
+            scanner = std::make_unique<Scanner>(std::move(reader), displayPath, canonicalPath, stringPool, report);
+        } else if (match->second->isValid()) {
+            scanner = std::make_unique<Scanner>(match->second.get(), displayPath, canonicalPath, stringPool, report);
+        } else {
+            // Scan it again so that its errors are reported at the point where the module is parsed.
+            scanner = std::make_unique<Scanner>(std::make_unique<MemoryReader>(match->second->getText()), displayPath, canonicalPath, stringPool, report);
+        }
         // Now, prepare the first token of the next file.
         nextToken();
 
@@ -175,6 +273,10 @@ namespace wiz {
         std::unique_ptr<Reader> reader;
 
         if (importModule(path, ImportOptions::of<ImportOptionType::AllowShellResources>(), displayPath, canonicalPath, reader) != ImportResult::Failed) {
+            if (jobCount > 1) {
+                prescanModules(canonicalPath, std::move(reader));
+            }
+
             pushScanner(displayPath, canonicalPath, std::move(reader));
             importManager->setCurrentPath(scanner->getLocation().canonicalPath);
             importManager->setStartPath(importManager->getCurrentPath());
@@ -2135,7 +2237,7 @@ namespace wiz {
 
         const auto suffixOffset = t.findFirstOf("ui"_sv);
         if (suffixOffset != SIZE_MAX) {
-            suffix = t.sub(suffixOffset);
+            suffix = stringPool->intern(t.sub(suffixOffset));
             t = t.sub(0, suffixOffset);
         }
 
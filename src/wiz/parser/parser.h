@@ -19,6 +19,7 @@
 namespace wiz {
     class Reader;
     class Scanner;
+    class ScannedSource;
     class ImportManager;
 
     enum class Keyword;
@@ -34,8 +35,15 @@ namespace wiz {
             Parser(StringPool* stringPool, ImportManager* importManager, Report* report);
             ~Parser();
 
+            // Sets how many threads may be used to read and scan imported modules ahead of parsing. 1 disables this.
+            void setJobCount(std::size_t value);
+
             FwdUniquePtr<const Statement> parse(StringView path);
 
+            // The number of modules that were read and scanned ahead of parsing, and the time that took, for stats.
+            std::size_t getPrescannedModuleCount() const;
+            double getPrescanDuration() const;
+
         private:
             Parser(const Parser&) = delete;  
             Parser& operator=(const Parser&) = delete;
@@ -57,6 +65,7 @@ namespace wiz {
             void skipToNextStatement();
             bool checkIdentifier();
             ImportResult importModule(StringView originalPath, ImportOptions importOptions, StringView& displayPath, StringView& canonicalPath, std::unique_ptr<Reader>& reader);
+            void prescanModules(StringView canonicalPath, std::unique_ptr<Reader> reader);
             void pushScanner(StringView displayPath, StringView canonicalPath, std::unique_ptr<Reader> reader);
             void popScanner();
 
@@ -118,11 +127,14 @@ namespace wiz {
 
             Token token;
             std::size_t symbolIndex;
+            std::size_t jobCount;
+            double prescanDuration;
 
             std::unique_ptr<Scanner> scanner;
             std::vector<Token> lookaheadBuffer;
             std::vector<std::unique_ptr<Scanner>> scannerStack;
             std::unordered_set<StringView> alreadyImportedPaths;
+            InternedStringMap<std::unique_ptr<ScannedSource>> scannedSources;
     };
 }
 
@@ -2,6 +2,7 @@
 #include <utility>
 
 #include <wiz/utility/text.h>
+#include <wiz/utility/logger.h>
 #include <wiz/utility/report.h>
 #include <wiz/utility/reader.h>
 #include <wiz/parser/token.h>
@@ -10,6 +11,61 @@
 namespace wiz {
     namespace {
         const char* const ErrorText = "<error>";
+
+        enum class CharClass : std::uint8_t {
+            Whitespace = 1 << 0,
+            IdentifierStart = 1 << 1,
+            IdentifierPart = 1 << 2,
+            DecimalDigit = 1 << 3,
+            HexadecimalDigit = 1 << 4,
+        };
+
+        struct CharClassTable {
+            constexpr CharClassTable()
+            : entries() {
+                for (std::size_t i = 0; i != 256; ++i) {
+                    const auto c = static_cast<char>(i);
+                    const bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+                    const bool digit = c >= '0' && c <= '9';
+                    const bool hexLetter = (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+
+                    std::uint8_t entry = 0;
+                    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                        entry |= static_cast<std::uint8_t>(CharClass::Whitespace);
+                    }
+                    if (letter) {
+                        entry |= static_cast<std::uint8_t>(CharClass::IdentifierStart);
+                    }
+                    if (letter || digit) {
+                        entry |= static_cast<std::uint8_t>(CharClass::IdentifierPart);
+                    }
+                    if (digit) {
+                        entry |= static_cast<std::uint8_t>(CharClass::DecimalDigit);
+                    }
+                    if (digit || hexLetter) {
+                        entry |= static_cast<std::uint8_t>(CharClass::HexadecimalDigit);
+                    }
+                    entries[i] = entry;
+                }
+            }
+
+            std::uint8_t entries[256];
+        };
+
+        constexpr CharClassTable charClassTable;
+
+        bool hasCharClass(char c, CharClass charClass) {
+            return (charClassTable.entries[static_cast<std::uint8_t>(c)] & static_cast<std::uint8_t>(charClass)) != 0;
+        }
+
+        // Returns the position of the first character at or after the given position that is not in charClass.
+        std::size_t skipCharClass(StringView buffer, std::size_t position, CharClass charClass) {
+            const auto length = buffer.getLength();
+            while (position < length && hasCharClass(buffer[position], charClass)) {
+                position++;
+            }
+            return position;
+        }
     }
 
     enum class Scanner::State {
@@ -62,6 +118,29 @@ namespace wiz {
         StringPool* stringPool,
         Report* report)
     : reader(std::move(reader)),
+    scannedSource(nullptr),
+    scannedIndex(0),
+    location(originalPath, expandedPath, 0),
+    commentStartLocation(originalPath, expandedPath, 0),
+    stringPool(stringPool),
+    report(report),
+    terminator(0),
+    position(0),
+    state(State::Start),
+    baseTokenType(TokenType::None),
+    intermediateCharCode(0) {}
+
+    Scanner::Scanner(
+        const ScannedSource* scannedSource,
+        StringView originalPath,
+        StringView expandedPath,
+        StringPool* stringPool,
+        Report* report)
+    : reader(),
+    scannedSource(scannedSource),
+    scannedIndex(0),
+    // Merge into the shared pool in parse order, so the result doesn't depend on how scanning was scheduled.
+    scannedTexts(stringPool->merge(scannedSource->stringPool)),
     location(originalPath, expandedPath, 0),
     commentStartLocation(originalPath, expandedPath, 0),
     stringPool(stringPool),
@@ -79,90 +158,59 @@ namespace wiz {
     }
 
     Token Scanner::next() {
+        if (scannedSource != nullptr) {
+            return replay();
+        }
+
         std::string text;
         while (true) {
-            while (position < buffer.length()) {
+            while (position < buffer.getLength()) {
                 char c = buffer[position];
                 switch (state) {
-                    case State::Start:
+                    case State::Start: {
+                        const auto length = buffer.getLength();
+                        if (hasCharClass(c, CharClass::Whitespace)) {
+                            position = skipCharClass(buffer, position + 1, CharClass::Whitespace);
+                            continue;
+                        }
+                        if (hasCharClass(c, CharClass::IdentifierStart)) {
+                            const auto end = skipCharClass(buffer, position + 1, CharClass::IdentifierPart);
+                            if (end < length) {
+                                const auto internedText = stringPool->intern(buffer.sub(position, end - position));
+                                position = end;
+                                return Token(TokenType::Identifier, findKeyword(internedText), internedText);
+                            }
+
+                            // The identifier runs into the end of the buffer, let the Identifier state finish it.
+                            text.append(buffer.getData() + position, end - position);
+                            state = State::Identifier;
+                            position = end;
+                            continue;
+                        }
+                        if (c >= '1' && c <= '9') {
+                            const auto end = skipCharClass(buffer, position + 1, CharClass::DecimalDigit);
+                            if (end < length && buffer[end] != '_' && buffer[end] != 'u' && buffer[end] != 'i') {
+                                const auto internedText = stringPool->intern(buffer.sub(position, end - position));
+                                position = end;
+                                return Token(TokenType::Integer, internedText);
+                            }
+
+                            // Digit separators and suffixes need the IntegerDigits state.
+                            text.append(buffer.getData() + position, end - position);
+                            state = State::IntegerDigits;
+                            position = end;
+                            continue;
+                        }
+
                         switch (c) {
                             case '0':
                                 state = State::LeadingZero;
                                 text += c;
                                 break;
-                            case '1':
-                            case '2':
-                            case '3':
-                            case '4':
-                            case '5':
-                            case '6':
-                            case '7':
-                            case '8':
-                            case '9':
-                                state = State::IntegerDigits;
-                                text += c;
-                                break;
-                            case '_':
-                            case 'a':
-                            case 'b':
-                            case 'c':
-                            case 'd':
-                            case 'e':
-                            case 'f':
-                            case 'g':
-                            case 'h':
-                            case 'i':
-                            case 'j':
-                            case 'k':
-                            case 'l':
-                            case 'm':
-                            case 'n':
-                            case 'o':
-                            case 'p':
-                            case 'q':
-                            case 'r':
-                            case 's':
-                            case 't':
-                            case 'u':
-                            case 'v':
-                            case 'w':
-                            case 'x':
-                            case 'y':
-                            case 'z':
-                            case 'A':
-                            case 'B':
-                            case 'C':
-                            case 'D':
-                            case 'E':
-                            case 'F':
-                            case 'G':
-                            case 'H':
-                            case 'I':
-                            case 'J':
-                            case 'K':
-                            case 'L':
-                            case 'M':
-                            case 'N':
-                            case 'O':
-                            case 'P':
-                            case 'Q':
-                            case 'R':
-                            case 'S':
-                            case 'T':
-                            case 'U':
-                            case 'V':
-                            case 'W':
-                            case 'X':
-                            case 'Y':
-                            case 'Z':
-                                state = State::Identifier;
-                                text += c;
-                                break;
                             case '\'': case '\"':
                                 terminator = c;
                                 state = State::String;
                                 break;
-                            case ' ': case '\t': case '\r': case '\n': break;
                             case ':': position++; return Token(TokenType::Colon);
                             case ',': position++; return Token(TokenType::Comma);
                             case '.': state = State::Dot; break;
@@ -195,78 +243,17 @@ namespace wiz {
                                 break;
                         }
                         break;
+                    }
                     case State::Identifier:
-                        switch (c) {
-                            case '_':
-                            case '0':
-                            case '1':
-                            case '2':
-                            case '3':
-                            case '4':
-                            case '5':
-                            case '6':
-                            case '7':
-                            case '8':
-                            case '9':
-                            case 'a':
-                            case 'b':
-                            case 'c':
-                            case 'd':
-                            case 'e':
-                            case 'f':
-                            case 'g':
-                            case 'h':
-                            case 'i':
-                            case 'j':
-                            case 'k':
-                            case 'l':
-                            case 'm':
-                            case 'n':
-                            case 'o':
-                            case 'p':
-                            case 'q':
-                            case 'r':
-                            case 's':
-                            case 't':
-                            case 'u':
-                            case 'v':
-                            case 'w':
-                            case 'x':
-                            case 'y':
-                            case 'z':
-                            case 'A':
-                            case 'B':
-                            case 'C':
-                            case 'D':
-                            case 'E':
-                            case 'F':
-                            case 'G':
-                            case 'H':
-                            case 'I':
-                            case 'J':
-                            case 'K':
-                            case 'L':
-                            case 'M':
-                            case 'N':
-                            case 'O':
-                            case 'P':
-                            case 'Q':
-                            case 'R':
-                            case 'S':
-                            case 'T':
-                            case 'U':
-                            case 'V':
-                            case 'W':
-                            case 'X':
-                            case 'Y':
-                            case 'Z':
-                                text += c;
-                                break;
-                            default: {
-                                state = State::Start;
-                                const auto internedText = stringPool->intern(text);
-                                return Token(TokenType::Identifier, findKeyword(internedText), internedText);
-                            }
+                        if (hasCharClass(c, CharClass::IdentifierPart)) {
+                            const auto end = skipCharClass(buffer, position + 1, CharClass::IdentifierPart);
+                            text.append(buffer.getData() + position, end - position);
+                            position = end;
+                            continue;
+                        } else {
+                            state = State::Start;
+                            const auto internedText = stringPool->intern(text);
+                            return Token(TokenType::Identifier, findKeyword(internedText), internedText);
                         }
                         break;
                     case State::String:
@@ -287,9 +274,15 @@ namespace wiz {
                             case '\\':
                                 state = State::StringEscape;
                                 break;
-                            default:
-                                text += c;
-                                break;
+                            default: {
+                                auto end = position + 1;
+                                while (end < buffer.getLength() && buffer[end] != terminator && buffer[end] != '\\') {
+                                    end++;
+                                }
+                                text.append(buffer.getData() + position, end - position);
+                                position = end;
+                                continue;
+                            }
                         }
                         break;
                     case State::StringEscape:
@@ -421,21 +414,15 @@ namespace wiz {
                         }
                         break;
                     case State::IntegerDigits:
+                        if (hasCharClass(c, CharClass::DecimalDigit)) {
+                            const auto end = skipCharClass(buffer, position + 1, CharClass::DecimalDigit);
+                            text.append(buffer.getData() + position, end - position);
+                            position = end;
+                            continue;
+                        }
                         switch (c) {
                             case '_':
                                 break;
-                            case '0':
-                            case '1':
-                            case '2':
-                            case '3':
-                            case '4':
-                            case '5':
-                            case '6':
-                            case '7':
-                            case '8':
-                            case '9':
-                                text += c;
-                                break;
                             case 'u': case 'i':
                                 text += c;
                                 baseTokenType = TokenType::Integer;
@@ -447,33 +434,15 @@ namespace wiz {
                         }
                         break;
                     case State::HexadecimalDigits:
+                        if (hasCharClass(c, CharClass::HexadecimalDigit)) {
+                            const auto end = skipCharClass(buffer, position + 1, CharClass::HexadecimalDigit);
+                            text.append(buffer.getData() + position, end - position);
+                            position = end;
+                            continue;
+                        }
                         switch (c) {
                             case '_':
                                 break;
-                            case '0':
-                            case '1':
-                            case '2':
-                            case '3':
-                            case '4':
-                            case '5':
-                            case '6':
-                            case '7':
-                            case '8':
-                            case '9':
-                            case 'a':
-                            case 'b':
-                            case 'c':
-                            case 'd':
-                            case 'e':
-                            case 'f':
-                            case 'A':
-                            case 'B':
-                            case 'C':
-                            case 'D':
-                            case 'E':
-                            case 'F':
-                                text += c;
-                                break;
                             case 'u': case 'i':
                                 text += c;
                                 baseTokenType = TokenType::Hexadecimal;
@@ -526,76 +495,11 @@ namespace wiz {
                         }
                         break;
                     case State::LiteralSuffix:
-                        switch (c) {
-                            case '_':
-                            case '0':
-                            case '1':
-                            case '2':
-                            case '3':
-                            case '4':
-                            case '5':
-                            case '6':
-                            case '7':
-                            case '8':
-                            case '9':
-                            case 'a':
-                            case 'b':
-                            case 'c':
-                            case 'd':
-                            case 'e':
-                            case 'f':
-                            case 'g':
-                            case 'h':
-                            case 'i':
-                            case 'j':
-                            case 'k':
-                            case 'l':
-                            case 'm':
-                            case 'n':
-                            case 'o':
-                            case 'p':
-                            case 'q':
-                            case 'r':
-                            case 's':
-                            case 't':
-                            case 'u':
-                            case 'v':
-                            case 'w':
-                            case 'x':
-                            case 'y':
-                            case 'z':
-                            case 'A':
-                            case 'B':
-                            case 'C':
-                            case 'D':
-                            case 'E':
-                            case 'F':
-                            case 'G':
-                            case 'H':
-                            case 'I':
-                            case 'J':
-                            case 'K':
-                            case 'L':
-                            case 'M':
-                            case 'N':
-                            case 'O':
-                            case 'P':
-                            case 'Q':
-                            case 'R':
-                            case 'S':
-                            case 'T':
-                            case 'U':
-                            case 'V':
-                            case 'W':
-                            case 'X':
-                            case 'Y':
-                            case 'Z':
-                                text += c;
-                                break;
-                            default: {
-                                state = State::Start;
-                                return Token(baseTokenType, Keyword::None, stringPool->intern(text));
-                            }
+                        if (hasCharClass(c, CharClass::IdentifierPart)) {
+                            text += c;
+                        } else {
+                            state = State::Start;
+                            return Token(baseTokenType, Keyword::None, stringPool->intern(text));
                         }
                         break;
                     case State::Exclamation:
@@ -684,13 +588,21 @@ namespace wiz {
                                 return Token(TokenType::Slash);
                         }
                         break;
-                    case State::DoubleSlashComment: break;
-                    case State::SlashStarComment:
-                        switch (c) {
-                            case '*': state = State::SlashStarCommentStar;
-                            default: break;
-                        }
+                    case State::DoubleSlashComment:
+                        // The rest of the line is a comment.
+                        position = buffer.getLength();
+                        continue;
+                    case State::SlashStarComment: {
+                        const auto length = buffer.getLength();
+                        const auto star = std::memchr(buffer.getData() + position, '*', length - position);
+                        if (star == nullptr) {
+                            position = length;
+                            continue;
+                        }
+                        position = static_cast<std::size_t>(static_cast<const char*>(star) - buffer.getData());
+                        state = State::SlashStarCommentStar;
                         break;
+                    }
                     case State::SlashStarCommentStar:
                         switch (c) {
                             case '/': state = State::Start; break;
@@ -891,4 +803,63 @@ namespace wiz {
         }
         return Token(TokenType::EndOfFile);
     }
+
+    Token Scanner::replay() {
+        const auto& tokens = scannedSource->tokens;
+
+        // The recorded tokens always end in an end-of-file, which is repeated for any calls past the end.
+        const auto index = scannedIndex < tokens.size() - 1 ? scannedIndex++ : tokens.size() - 1;
+        auto token = tokens[index];
+        location.line = scannedSource->lines[index];
+
+        if (hasInternedText(token.type)) {
+            token.text = scannedTexts[StringPool::getSymbolId(token.text)];
+        }
+
+        return token;
+    }
+
+    ScannedSource::ScannedSource(std::unique_ptr<Reader> reader, StringView canonicalPath)
+    : reader(std::move(reader)),
+    canonicalPath(canonicalPath),
+    valid(false) {}
+
+    ScannedSource::~ScannedSource() {}
+
+    void ScannedSource::scan() {
+        text = reader->readFully();
+        reader = nullptr;
+
+        // Diagnostics are discarded here. A source with errors is rescanned by the parser, so they are reported in order.
+        Report report(std::make_unique<MemoryLogger>());
+        Scanner scanner(std::make_unique<MemoryReader>(StringView(text)), canonicalPath, canonicalPath, &stringPool, &report);
+
+        while (true) {
+            const auto token = scanner.next();
+            tokens.push_back(token);
+            lines.push_back(scanner.getLocation().line);
+
+            if (token.type == TokenType::EndOfFile) {
+                break;
+            }
+        }
+
+        valid = report.validate();
+    }
+
+    StringView ScannedSource::getCanonicalPath() const {
+        return canonicalPath;
+    }
+
+    StringView ScannedSource::getText() const {
+        return StringView(text);
+    }
+
+    const std::vector<Token>& ScannedSource::getTokens() const {
+        return tokens;
+    }
+
+    bool ScannedSource::isValid() const {
+        return valid;
+    }
 }
\ No newline at end of file
@@ -5,7 +5,9 @@
 #include <string>
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include <wiz/parser/token.h>
 #include <wiz/utility/string_pool.h>
 #include <wiz/utility/source_location.h>
 
@@ -13,12 +15,45 @@ namespace wiz {
     class Reader;
     class Report;
     class Location;
-    struct Token;
-    enum class TokenType;
+
+    // A source file that was read and scanned ahead of parsing, possibly on another thread.
+    // Token text is interned into a private StringPool, so that different sources can be scanned at the same time.
+    class ScannedSource {
+        public:
+            ScannedSource(std::unique_ptr<Reader> reader, StringView canonicalPath);
+            ~ScannedSource();
+
+            // Reads the whole source and records every token up to and including the end-of-file.
+            // Touches no state outside of this object.
+            void scan();
+
+            StringView getCanonicalPath() const;
+            StringView getText() const;
+            const std::vector<Token>& getTokens() const;
+            bool isValid() const;
+
+        private:
+            friend class Scanner;
+
+            ScannedSource(const ScannedSource&) = delete;
+            ScannedSource& operator=(const ScannedSource&) = delete;
+
+            std::unique_ptr<Reader> reader;
+            StringView canonicalPath;
+            std::string text;
+            StringPool stringPool;
+            std::vector<Token> tokens;
+            // The line number reported by the scanner after producing each token.
+            std::vector<std::size_t> lines;
+            bool valid;
+    };
 
     class Scanner {
         public:
             Scanner(std::unique_ptr<Reader> reader, StringView originalPath, StringView expandedPath, StringPool* stringPool, Report* report);
+            // Replays the tokens of a valid source that was already scanned.
+            // The private pool of the source is merged into stringPool once, up front, and the replayed tokens refer to the merged text.
+            Scanner(const ScannedSource* scannedSource, StringView originalPath, StringView expandedPath, StringPool* stringPool, Report* report);
             ~Scanner();
 
             SourceLocation getLocation() const;
@@ -27,7 +62,13 @@ namespace wiz {
         private:
             enum class State;
 
+            Token replay();
+
             std::unique_ptr<Reader> reader;
+            const ScannedSource* scannedSource;
+            std::size_t scannedIndex;
+            // The text in stringPool for each symbol ID in the private pool of scannedSource.
+            std::vector<StringView> scannedTexts;
             SourceLocation location;
             SourceLocation commentStartLocation;
             StringPool* stringPool;
@@ -38,7 +79,7 @@ namespace wiz {
             TokenType baseTokenType;
             std::uint8_t intermediateCharCode;
 
-            std::string buffer;
+            StringView buffer;
     };
 }
 
@@ -1,12 +1,12 @@
+#include <cstdint>
 #include <cstring>
-#include <unordered_map>
 
 #include <wiz/parser/token.h>
 #include <wiz/utility/text.h>
 
 namespace wiz {
     namespace {
-        const char* const keywordNames[] = {
+        constexpr const char* keywordNames[] = {
             "(no keyword)",
             "alignof",
             "as",
@@ -58,6 +58,49 @@ namespace wiz {
 
         static_assert(sizeof(keywordNames) / sizeof(*keywordNames) == static_cast<std::size_t>(Keyword::Count), "`keywordNames` table must have an entry for every `Keyword`");
 
+        // Keywords are recognized with a perfect hash of their first two characters, last character and length.
+        // If a new keyword collides with an existing one, the static_assert below fails and the multipliers need adjusting.
+        const std::size_t KeywordHashTableSize = 128;
+        const std::size_t MinKeywordLength = 2;
+
+        constexpr std::size_t getKeywordHash(const char* text, std::size_t length) {
+            return (static_cast<std::uint8_t>(text[0]) * 20
+                + static_cast<std::uint8_t>(text[1]) * 26
+                + static_cast<std::uint8_t>(text[length - 1]) * 3
+                + length) % KeywordHashTableSize;
+        }
+
+        constexpr std::size_t getKeywordNameLength(const char* text) {
+            std::size_t length = 0;
+            while (text[length] != '\0') {
+                length++;
+            }
+            return length;
+        }
+
+        struct KeywordHashTable {
+            constexpr KeywordHashTable()
+            : keywords(), lengths(), collisions(0) {
+                for (std::size_t i = 1; i != static_cast<std::size_t>(Keyword::Count); ++i) {
+                    const auto length = getKeywordNameLength(keywordNames[i]);
+                    const auto hash = getKeywordHash(keywordNames[i], length);
+                    if (keywords[hash] != 0 || length < MinKeywordLength) {
+                        collisions++;
+                    }
+                    keywords[hash] = static_cast<std::uint8_t>(i);
+                    lengths[hash] = static_cast<std::uint8_t>(length);
+                }
+            }
+
+            std::uint8_t keywords[KeywordHashTableSize];
+            std::uint8_t lengths[KeywordHashTableSize];
+            std::size_t collisions;
+        };
+
+        constexpr KeywordHashTable keywordHashTable;
+
+        static_assert(keywordHashTable.collisions == 0, "`getKeywordHash` must map every keyword to a distinct slot");
+
         const char* const tokenNames[] = {
             "nothing",
             "end-of-file",
@@ -185,14 +228,33 @@ namespace wiz {
     }
 
     Keyword findKeyword(StringView text) {
-        static std::unordered_map<StringView, Keyword> keywords;
-        if (keywords.empty()) {
-            for (std::size_t i = 0; i != sizeof(keywordNames) / sizeof(*keywordNames); ++i) {
-                keywords[StringView(keywordNames[i])] = static_cast<Keyword>(i);
-            }
+        const auto length = text.getLength();
+        if (length < MinKeywordLength) {
+            return Keyword::None;
         }
 
-        const auto match = keywords.find(text);
-        return match != keywords.end() ? match->second : Keyword::None;
+        const auto hash = getKeywordHash(text.getData(), length);
+        const auto keyword = keywordHashTable.keywords[hash];
+        if (keyword != 0
+        && keywordHashTable.lengths[hash] == length
+        && std::memcmp(keywordNames[keyword], text.getData(), length) == 0) {
+            return static_cast<Keyword>(keyword);
+        }
+        return Keyword::None;
+    }
+
+    bool hasInternedText(TokenType type) {
+        switch (type) {
+            case TokenType::Identifier:
+            case TokenType::Integer:
+            case TokenType::Hexadecimal:
+            case TokenType::Octal:
+            case TokenType::Binary:
+            case TokenType::String:
+            case TokenType::Character:
+                return true;
+            default:
+                return false;
+        }
     }
 }
\ No newline at end of file
@@ -165,6 +165,8 @@ namespace wiz {
     std::string getVerboseTokenName(Token token);
     StringView getKeywordName(Keyword keyword);
     Keyword findKeyword(StringView text);
+    // Returns true if tokens of this type carry text that the scanner interned.
+    bool hasInternedText(TokenType type);
 }
 
 #endif
@@ -137,11 +137,11 @@ namespace wiz {
 
         // Instruction encodings.
         const auto encodingImplicit = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size();
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(captureLists);
@@ -151,11 +151,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingU8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 1;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -165,11 +165,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingU16Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 2;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -181,11 +181,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingPCRelativeI8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 1;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 buffer.insert(buffer.end(), options.opcode.begin(), options.opcode.end());
 
                 const auto base = static_cast<std::int32_t>(bank->getAddress().absolutePosition.get() & 0xFFFF);
@@ -201,13 +201,19 @@ namespace wiz {
                     return false;
                 }
                 return true;
+            },
+            [](const Bank* bank, const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
+                const auto base = static_cast<std::int32_t>(bank->getAddress().absolutePosition.get() & 0xFFFF);
+                const auto dest = static_cast<std::int32_t>(captureLists[options.parameter[0]][0]->variant.get<InstructionOperand::Integer>().value);
+                const auto offset = dest - base - 2;
+                return offset >= -128 && offset <= 127;
             });
         const auto encodingI8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 1;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(bank);
                 buffer.insert(buffer.end(), options.opcode.begin(), options.opcode.end());
 
@@ -224,10 +230,10 @@ namespace wiz {
                 return true;
             });
         const auto encodingRepeatedImplicit = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 return static_cast<std::size_t>(captureLists[options.parameter[0]][0]->variant.get<InstructionOperand::Integer>().value) * options.opcode.size();
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -239,11 +245,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingBitIndex = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size();
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -175,11 +175,11 @@ namespace wiz {
 
         // Instruction encodings.
         const auto encodingImplicit = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size();
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(captureLists);
@@ -189,11 +189,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingU8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 1;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -203,11 +203,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingU16Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 2;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -219,11 +219,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingPCRelativeI8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 1;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 buffer.insert(buffer.end(), options.opcode.begin(), options.opcode.end());
 
                 const auto base = static_cast<std::int32_t>(bank->getAddress().absolutePosition.get() & 0xFFFF);
@@ -239,12 +239,18 @@ namespace wiz {
                     report->error("pc-relative offset is outside of representable signed 8-bit range -128..127", location);
                     return false;
                 }
+            },
+            [](const Bank* bank, const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
+                const auto base = static_cast<std::int32_t>(bank->getAddress().absolutePosition.get() & 0xFFFF);
+                const auto dest = static_cast<std::int32_t>(captureLists[options.parameter[0]][0]->variant.get<InstructionOperand::Integer>().value);
+                const auto offset = dest - base - 2;
+                return offset >= -128 && offset <= 127;
             });
         const auto encodingRepeatedImplicit = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 return static_cast<std::size_t>(captureLists[options.parameter[0]][0]->variant.get<InstructionOperand::Integer>().value) * options.opcode.size();
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -256,10 +262,10 @@ namespace wiz {
                 return true;
             });
         const auto encodingRepeatedU8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 return static_cast<std::size_t>(captureLists[options.parameter[1]][0]->variant.get<InstructionOperand::Integer>().value) * (options.opcode.size() + 1);
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -273,10 +279,10 @@ namespace wiz {
                 return true;
             });
         const auto encodingRepeatedU16Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 return static_cast<std::size_t>(captureLists[options.parameter[1]][0]->variant.get<InstructionOperand::Integer>().value) * (options.opcode.size() + 2);
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -291,11 +297,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingU8OperandBitIndex = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 1;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -546,11 +552,11 @@ namespace wiz {
                         patternImmBitSubscript->clone()))));
 
             const auto encodingU8OperandBitIndexBranch = builtins.createInstructionEncoding(
-                [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+                [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                     static_cast<void>(captureLists);
                     return options.opcode.size() + 2;
                 },
-                [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+                [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                     // goto dest if *(zp) $ n
                     // zp = 0th capture of $0
                     // n = $2th capture of $1
@@ -574,13 +580,19 @@ namespace wiz {
                         report->error("pc-relative offset is outside of representable signed 8-bit range -128..127", location);
                         return false;
                     }
+                },
+                [](const Bank* bank, const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
+                    const auto base = static_cast<int>(bank->getAddress().absolutePosition.get());
+                    const auto dest = static_cast<int>(captureLists[options.parameter[3]][0]->variant.get<InstructionOperand::Integer>().value);
+                    const auto offset = dest - base - 3;
+                    return offset >= -128 && offset <= 127;
                 });
             const auto encodingU8OperandBitIndexLongBranch = builtins.createInstructionEncoding(
-                [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+                [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                     static_cast<void>(captureLists);
                     return options.opcode.size() + 3;
                 },
-                [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+                [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                     static_cast<void>(report);
                     static_cast<void>(bank);
                     static_cast<void>(location);
@@ -650,11 +662,11 @@ namespace wiz {
             tst = scope->createDefinition(nullptr, Definition::BuiltinVoidIntrinsic(), stringPool->intern("tst"), decl);
 
             const auto encodingZeroPageBitwiseTest = builtins.createInstructionEncoding(
-                [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+                [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                     static_cast<void>(captureLists);
                     return options.opcode.size() + 3;
                 },
-                [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+                [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                     static_cast<void>(report);
                     static_cast<void>(bank);
                     static_cast<void>(location);
@@ -667,11 +679,11 @@ namespace wiz {
                     return true;
                 });
             const auto encodingAbsoluteBitwiseTest = builtins.createInstructionEncoding(
-                [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+                [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                     static_cast<void>(captureLists);
                     return options.opcode.size() + 3;
                 },
-                [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+                [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                     static_cast<void>(report);
                     static_cast<void>(bank);
                     static_cast<void>(location);
@@ -685,11 +697,11 @@ namespace wiz {
                     return true;
                 });
             const auto encodingBlockTransfer = builtins.createInstructionEncoding(
-                [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+                [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                     static_cast<void>(captureLists);
                     return options.opcode.size() + 6;
                 },
-                [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+                [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                     static_cast<void>(report);
                     static_cast<void>(bank);
                     static_cast<void>(location);
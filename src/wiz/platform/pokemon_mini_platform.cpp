@@ -160,11 +160,11 @@ namespace wiz {
 
         // Instruction encodings.
         const auto encodingImplicit = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size();
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(captureLists);
@@ -174,11 +174,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingU8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 1;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -188,11 +188,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingU16Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 2;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -204,11 +204,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingU8OperandU8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 2;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -219,11 +219,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingPCRelativeI8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 1;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 buffer.insert(buffer.end(), options.opcode.begin(), options.opcode.end());
 
                 const auto base = static_cast<std::int32_t>(bank->getAddress().absolutePosition.get() & 0xFFFF);
@@ -239,13 +239,19 @@ namespace wiz {
                     return false;
                 }
                 return true;
+            },
+            [](const Bank* bank, const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
+                const auto base = static_cast<std::int32_t>(bank->getAddress().absolutePosition.get() & 0xFFFF);
+                const auto dest = static_cast<std::int32_t>(captureLists[options.parameter[0]][0]->variant.get<InstructionOperand::Integer>().value);
+                const auto offset = dest - base - 2;
+                return offset >= -128 && offset <= 127;
             });
         const auto encodingPCRelativeI16Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 2;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 buffer.insert(buffer.end(), options.opcode.begin(), options.opcode.end());
 
                 const auto base = static_cast<std::int32_t>(bank->getAddress().absolutePosition.get());
@@ -264,13 +270,19 @@ namespace wiz {
                     report->error("pc-relative offset is outside of representable signed 8-bit range -32768..32767", location);
                     return false;
                 }
+            },
+            [](const Bank* bank, const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
+                const auto base = static_cast<std::int32_t>(bank->getAddress().absolutePosition.get());
+                const auto dest = static_cast<std::int32_t>(captureLists[options.parameter[0]][0]->variant.get<InstructionOperand::Integer>().value);
+                const auto offset = dest - base - 3;
+                return offset >= -32768 && offset <= 32767;
             });
         const auto encodingI8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 1;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(bank);
 
                 buffer.insert(buffer.end(), options.opcode.begin(), options.opcode.end());
@@ -288,10 +300,10 @@ namespace wiz {
                 return true;
             });
         const auto encodingRepeatedImplicit = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 return static_cast<std::size_t>(captureLists[options.parameter[0]][0]->variant.get<InstructionOperand::Integer>().value) * options.opcode.size();
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -303,10 +315,10 @@ namespace wiz {
                 return true;
             });
         const auto encodingRepeatedU8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 return static_cast<std::size_t>(captureLists[options.parameter[1]][0]->variant.get<InstructionOperand::Integer>().value) * (options.opcode.size() + 1);
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
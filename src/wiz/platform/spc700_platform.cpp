@@ -221,11 +221,11 @@ namespace wiz {
 
         // Instruction encodings.
         const auto encodingImplicit = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size();
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -235,11 +235,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingU8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 1;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -249,11 +249,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingU16Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 2;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -266,11 +266,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingPCRelativeI8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 1;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 buffer.insert(buffer.end(), options.opcode.begin(), options.opcode.end());
 
                 const auto base = static_cast<std::int32_t>(bank->getAddress().absolutePosition.get() & 0xFFFF);
@@ -286,13 +286,19 @@ namespace wiz {
                     report->error("pc-relative offset is outside of representable signed 8-bit range -128..127", location);
                     return false;
                 }
+            },
+            [](const Bank* bank, const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
+                const auto base = static_cast<std::int32_t>(bank->getAddress().absolutePosition.get() & 0xFFFF);
+                const auto dest = static_cast<std::int32_t>(captureLists[options.parameter[0]][0]->variant.get<InstructionOperand::Integer>().value);
+                const auto offset = dest - base - 2;
+                return offset >= -128 && offset <= 127;
             });
         const auto encodingU8OperandPCRelativeI8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 2;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 buffer.insert(buffer.end(), options.opcode.begin(), options.opcode.end());
                 buffer.push_back(static_cast<std::uint8_t>(captureLists[options.parameter[0]][0]->variant.get<InstructionOperand::Integer>().value));
 
@@ -309,13 +315,19 @@ namespace wiz {
                     report->error("pc-relative offset is outside of representable signed 8-bit range -128..127", location);
                     return false;
                 }
+            },
+            [](const Bank* bank, const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
+                const auto base = static_cast<int>(bank->getAddress().absolutePosition.get());
+                const auto dest = static_cast<int>(captureLists[options.parameter[1]][0]->variant.get<InstructionOperand::Integer>().value);
+                const auto offset = dest - base - 2;
+                return offset >= -128 && offset <= 127;
             });
         const auto encodingU8OperandBitIndex = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 1;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -331,11 +343,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingU8OperandBitIndexBranch = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 2;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 // goto dest if *(zp) $ n
                 // zp = 0th capture of $0
                 // n = $2th capture of $1
@@ -359,13 +371,19 @@ namespace wiz {
                     report->error("pc-relative offset is outside of representable signed 8-bit range -128..127", location);
                     return false;
                 }
+            },
+            [](const Bank* bank, const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
+                const auto base = static_cast<int>(bank->getAddress().absolutePosition.get());
+                const auto dest = static_cast<int>(captureLists[options.parameter[3]][0]->variant.get<InstructionOperand::Integer>().value);
+                const auto offset = dest - base - 3;
+                return offset >= -128 && offset <= 127;
             });
         const auto encodingU13OperandBitIndex = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 2;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(bank);
 
                 // *(abs) $ n bit-wise access.
@@ -387,10 +405,10 @@ namespace wiz {
                 }
             });
         const auto encodingRepeatedImplicit = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 return static_cast<std::size_t>(captureLists[options.parameter[0]][0]->variant.get<InstructionOperand::Integer>().value) * options.opcode.size();
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -402,10 +420,10 @@ namespace wiz {
                 return true;
             });
         const auto encodingRepeatedU8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 return static_cast<std::size_t>(captureLists[options.parameter[1]][0]->variant.get<InstructionOperand::Integer>().value) * (options.opcode.size() + 1);
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -419,10 +437,10 @@ namespace wiz {
                 return true;
             });
         const auto encodingRepeatedU16Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 return static_cast<std::size_t>(captureLists[options.parameter[1]][0]->variant.get<InstructionOperand::Integer>().value) * (options.opcode.size() + 2);
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -437,11 +455,11 @@ namespace wiz {
                 return true;
             });
         const auto encodingU8OperandU8Operand = builtins.createInstructionEncoding(
-            [](const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists) {
+            [](const InstructionOptions& options, const InstructionCaptureLists& captureLists) {
                 static_cast<void>(captureLists);
                 return options.opcode.size() + 2;
             },
-            [](Report* report, const Bank* bank, std::vector<std::uint8_t>& buffer, const InstructionOptions& options, const std::vector<std::vector<const InstructionOperand*>>& captureLists, SourceLocation location) {
+            [](Report* report, const Bank* bank, InstructionBuffer& buffer, const InstructionOptions& options, const InstructionCaptureLists& captureLists, SourceLocation location) {
                 static_cast<void>(report);
                 static_cast<void>(bank);
                 static_cast<void>(location);
@@ -0,0 +1,144 @@
+#ifdef WIZ_COUNT_ALLOCATIONS
+
+#include <new>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include <wiz/utility/allocation_counter.h>
+
+namespace wiz {
+    namespace {
+        thread_local std::size_t heapAllocationCount = 0;
+
+        void* tryAllocate(std::size_t size) {
+            ++heapAllocationCount;
+            return std::malloc(size != 0 ? size : 1);
+        }
+
+        void* tryAllocateAligned(std::size_t size, std::align_val_t alignment) {
+            ++heapAllocationCount;
+
+            const auto align = static_cast<std::size_t>(alignment);
+            // aligned_alloc wants a size that is a multiple of the alignment.
+            const auto alignedSize = size != 0 ? (size + align - 1) / align * align : align;
+#ifdef _WIN32
+            return _aligned_malloc(alignedSize, align);
+#else
+            return std::aligned_alloc(align, alignedSize);
+#endif
+        }
+
+        void freeAligned(void* ptr) {
+#ifdef _WIN32
+            _aligned_free(ptr);
+#else
+            std::free(ptr);
+#endif
+        }
+
+        template <typename Func>
+        void* allocate(Func tryAllocateFunc) {
+            while (true) {
+                if (const auto result = tryAllocateFunc()) {
+                    return result;
+                }
+                if (const auto handler = std::get_new_handler()) {
+                    handler();
+                } else {
+                    std::abort();
+                }
+            }
+        }
+    }
+
+    std::size_t getHeapAllocationCount() {
+        return heapAllocationCount;
+    }
+}
+
+// Replacements for every form of the global allocation functions, so that each heap allocation passes through the counter.
+// Only built for measurement, since it hides the default allocator from sanitizers and allocator interposers.
+void* operator new(std::size_t size) {
+    return wiz::allocate([=] { return wiz::tryAllocate(size); });
+}
+
+void* operator new[](std::size_t size) {
+    return wiz::allocate([=] { return wiz::tryAllocate(size); });
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return wiz::tryAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return wiz::tryAllocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return wiz::allocate([=] { return wiz::tryAllocateAligned(size, alignment); });
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return wiz::allocate([=] { return wiz::tryAllocateAligned(size, alignment); });
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return wiz::tryAllocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return wiz::tryAllocateAligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    wiz::freeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    wiz::freeAligned(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    wiz::freeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    wiz::freeAligned(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    wiz::freeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    wiz::freeAligned(ptr);
+}
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef WIZ_UTILITY_ALLOCATION_COUNTER_H
+#define WIZ_UTILITY_ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+namespace wiz {
+#ifdef WIZ_COUNT_ALLOCATIONS
+    // Returns how many times the global operator new has been called on the current thread.
+    // Taking the difference between two calls tells how many heap allocations a piece of code made.
+    // Only available in builds made with `make COUNT_ALLOCATIONS=1`, which replace the global allocation functions to count them.
+    std::size_t getHeapAllocationCount();
+#else
+    // Allocations aren't counted in this build, so the allocator is left alone.
+    inline std::size_t getHeapAllocationCount() {
+        return 0;
+    }
+#endif
+}
+
+#endif
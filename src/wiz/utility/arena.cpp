@@ -0,0 +1,163 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+
+#include <wiz/utility/arena.h>
+
+namespace wiz {
+    namespace {
+        // Chunks are aligned to their size, so the arena that owns a block can be found from the block's address alone.
+        const std::size_t ChunkSize = 64 * 1024;
+        const std::size_t ChunkHeaderSize = Arena::Granularity;
+        const std::size_t SlabChunkCount = 16;
+
+        static_assert(sizeof(Arena*) <= ChunkHeaderSize, "chunk header must fit the owning arena");
+
+        char* alignToChunk(char* ptr) {
+            const auto address = reinterpret_cast<std::uintptr_t>(ptr);
+            return ptr + ((ChunkSize - address % ChunkSize) % ChunkSize);
+        }
+    }
+
+    thread_local Arena* Arena::current = nullptr;
+
+    Arena::Scope::Scope(Arena* arena)
+    : previous(current) {
+        current = arena;
+    }
+
+    Arena::Scope::~Scope() {
+        current = previous;
+    }
+
+    Arena::TemporaryScope::TemporaryScope()
+    : previous(getCurrent()),
+    arena(nullptr) {
+        if (previous->child == nullptr) {
+            previous->child = std::make_unique<Arena>();
+            previous->child->temporary = true;
+        }
+
+        arena = previous->child.get();
+        current = arena;
+    }
+
+    Arena::TemporaryScope::~TemporaryScope() {
+        current = previous;
+
+        if (arena->liveCount == 0 && arena->usedSize != 0) {
+            arena->release();
+            ++arena->resetCount;
+        }
+    }
+
+    Arena::Arena()
+    : nextChunk(nullptr),
+    slabChunksRemaining(0),
+    chunkCount(0),
+    chunkPosition(nullptr),
+    chunkRemaining(0),
+    usedSize(0),
+    liveCount(0),
+    resetCount(0),
+    freeBlocks(),
+    temporary(false) {}
+
+    Arena::~Arena() {}
+
+    void Arena::deallocate(const void* ptr, std::size_t size) {
+        if (ptr == nullptr) {
+            return;
+        }
+
+        const auto chunk = reinterpret_cast<const char*>(reinterpret_cast<std::uintptr_t>(ptr) & ~static_cast<std::uintptr_t>(ChunkSize - 1));
+        const auto owner = *reinterpret_cast<Arena* const*>(chunk);
+        --owner->liveCount;
+
+        const auto blockSize = (size + Granularity - 1) / Granularity * Granularity;
+        if (blockSize <= MaxRecycledSize) {
+            auto& freeBlock = owner->freeBlocks[blockSize / Granularity - 1];
+            freeBlock = new (const_cast<void*>(ptr)) FreeBlock {freeBlock};
+        }
+    }
+
+    bool Arena::isTemporary() const {
+        return temporary;
+    }
+
+    std::size_t Arena::getUsedSize() const {
+        return usedSize + (child != nullptr ? child->getUsedSize() : 0);
+    }
+
+    std::size_t Arena::getChunkCount() const {
+        return chunkCount + largeBlocks.size() + (child != nullptr ? child->getChunkCount() : 0);
+    }
+
+    std::size_t Arena::getResetCount() const {
+        return resetCount + (child != nullptr ? child->getResetCount() : 0);
+    }
+
+    Arena* Arena::getCurrent() {
+        if (current == nullptr) {
+            std::fputs("internal error: arena allocation outside of any `Arena::Scope`\n", stderr);
+            std::abort();
+        }
+        return current;
+    }
+
+    void* Arena::allocateSlow(std::size_t blockSize) {
+        ++liveCount;
+        usedSize += blockSize;
+
+        // Large allocations get a block of their own, so that the rest of the current chunk stays usable.
+        if (blockSize > ChunkSize / 4) {
+            largeBlocks.push_back(std::unique_ptr<char[]>(new char[ChunkSize + ChunkHeaderSize + blockSize]));
+            const auto block = alignToChunk(largeBlocks.back().get());
+            *reinterpret_cast<Arena**>(block) = this;
+            return block + ChunkHeaderSize;
+        }
+
+        const auto chunk = allocateChunk();
+        chunkPosition = chunk + ChunkHeaderSize + blockSize;
+        chunkRemaining = ChunkSize - ChunkHeaderSize - blockSize;
+        return chunk + ChunkHeaderSize;
+    }
+
+    char* Arena::allocateChunk() {
+        if (slabChunksRemaining == 0) {
+            // One extra chunk's worth of space leaves room to align the first chunk. Pages that are never touched don't cost anything.
+            slabs.push_back(std::unique_ptr<char[]>(new char[(SlabChunkCount + 1) * ChunkSize]));
+            nextChunk = alignToChunk(slabs.back().get());
+            slabChunksRemaining = SlabChunkCount;
+        }
+
+        const auto chunk = nextChunk;
+        nextChunk += ChunkSize;
+        --slabChunksRemaining;
+        ++chunkCount;
+
+        *reinterpret_cast<Arena**>(chunk) = this;
+        return chunk;
+    }
+
+    void Arena::release() {
+        // Keep the first slab, since a temporary arena is usually needed again soon.
+        if (slabs.size() > 1) {
+            slabs.erase(slabs.begin() + 1, slabs.end());
+        }
+        largeBlocks.clear();
+
+        if (slabs.size() != 0) {
+            nextChunk = alignToChunk(slabs.front().get());
+            slabChunksRemaining = SlabChunkCount;
+        }
+        chunkCount = 0;
+        chunkPosition = nullptr;
+        chunkRemaining = 0;
+        usedSize = 0;
+
+        for (auto& freeBlock : freeBlocks) {
+            freeBlock = nullptr;
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#ifndef WIZ_UTILITY_ARENA_H
+#define WIZ_UTILITY_ARENA_H
+
+#include <new>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <wiz/utility/macros.h>
+
+namespace wiz {
+    // Bump allocator that hands out memory from large chunks, and releases all of it at once when destroyed.
+    // The arena never runs destructors. Objects placed in it must still be destroyed by their owners before the arena goes away.
+    // Blocks given back with deallocate() are kept on a free list for their size, and reused by later allocations.
+    class Arena {
+        public:
+            // Installs an arena as the current one for the lifetime of the scope, restoring the previous one afterwards.
+            class Scope {
+                public:
+                    Scope(Arena* arena);
+                    ~Scope();
+
+                private:
+                    Scope(const Scope&) = delete;
+                    Scope& operator=(const Scope&) = delete;
+
+                    Arena* previous;
+            };
+
+            // Installs a child of the current arena for short-lived work, like reductions whose results are only inspected.
+            // When the scope ends, the child is reset if everything allocated from it has been given back.
+            // Anything that outlives the scope keeps the child from being reset, so it stays valid until the parent goes away.
+            class TemporaryScope {
+                public:
+                    TemporaryScope();
+                    ~TemporaryScope();
+
+                private:
+                    TemporaryScope(const TemporaryScope&) = delete;
+                    TemporaryScope& operator=(const TemporaryScope&) = delete;
+
+                    Arena* previous;
+                    Arena* arena;
+            };
+
+            // Every block is a multiple of this size and alignment, which is enough for the node types that live in arenas.
+            static const std::size_t Granularity = 8;
+            // Blocks larger than this aren't reused after they are given back.
+            static const std::size_t MaxRecycledSize = 512;
+
+            Arena();
+            ~Arena();
+
+            WIZ_FORCE_INLINE void* allocate(std::size_t size) {
+                const auto blockSize = (size + Granularity - 1) / Granularity * Granularity;
+                if (blockSize <= MaxRecycledSize) {
+                    auto& freeBlock = freeBlocks[blockSize / Granularity - 1];
+                    if (freeBlock != nullptr) {
+                        const auto result = freeBlock;
+                        freeBlock = freeBlock->next;
+                        ++liveCount;
+                        return result;
+                    }
+                }
+                if (blockSize <= chunkRemaining) {
+                    const auto result = chunkPosition;
+                    chunkPosition += blockSize;
+                    chunkRemaining -= blockSize;
+                    usedSize += blockSize;
+                    ++liveCount;
+                    return result;
+                }
+                return allocateSlow(blockSize);
+            }
+
+            // Gives back a block handed out by allocate(), to whichever arena it came from.
+            static void deallocate(const void* ptr, std::size_t size);
+
+            bool isTemporary() const;
+            std::size_t getUsedSize() const;
+            std::size_t getChunkCount() const;
+            std::size_t getResetCount() const;
+
+            // Returns the arena installed by the innermost scope on this thread.
+            // Allocating outside of any scope is a bug, since nothing would ever release the memory.
+            static Arena* getCurrent();
+
+        private:
+            struct FreeBlock {
+                FreeBlock* next;
+            };
+
+            Arena(const Arena&) = delete;
+            Arena& operator=(const Arena&) = delete;
+
+            void* allocateSlow(std::size_t blockSize);
+            char* allocateChunk();
+            void release();
+
+            // Chunks are carved out of larger slabs, so that aligning them doesn't waste memory on each one.
+            std::vector<std::unique_ptr<char[]>> slabs;
+            std::vector<std::unique_ptr<char[]>> largeBlocks;
+            char* nextChunk;
+            std::size_t slabChunksRemaining;
+            std::size_t chunkCount;
+            char* chunkPosition;
+            std::size_t chunkRemaining;
+            std::size_t usedSize;
+            std::size_t liveCount;
+            std::size_t resetCount;
+            FreeBlock* freeBlocks[MaxRecycledSize / Granularity];
+
+            bool temporary;
+            std::unique_ptr<Arena> child;
+
+            static thread_local Arena* current;
+    };
+
+    // FwdAllocator for types whose instances live in the current arena.
+    // The matching FwdDeleter<T> should run the destructor, and then give the storage back with Arena::deallocate.
+    template <typename T>
+    struct ArenaFwdAllocator {
+        static_assert(alignof(T) <= Arena::Granularity, "arena blocks are not aligned enough for `T`");
+
+        template <typename... Args>
+        static T* create(Args&&... args) {
+            return new (Arena::getCurrent()->allocate(sizeof(T))) T(std::forward<Args>(args)...);
+        }
+    };
+}
+
+#endif
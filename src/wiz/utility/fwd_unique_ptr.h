@@ -22,9 +22,19 @@ namespace wiz {
     using FwdUniquePtr = UniquePtr<T, FwdDeleter<std::remove_cv_t<T>>>;
     //using FwdUniquePtr = std::unique_ptr<T, FwdDeleter<std::remove_cv_t<T>>>;
 
+    // Creates the instances handed out by makeFwdUnique.
+    // A type can specialize this to take its storage from somewhere other than the heap, if its FwdDeleter<T> matches.
+    template <typename T>
+    struct FwdAllocator {
+        template <typename... Args>
+        static T* create(Args&&... args) {
+            return new T(std::forward<Args>(args)...);
+        }
+    };
+
     template <typename T, typename... Args>
     FwdUniquePtr<T> makeFwdUnique(Args&&... args) {
-        return FwdUniquePtr<T>(new T(std::forward<Args>(args)...));
+        return FwdUniquePtr<T>(FwdAllocator<std::remove_cv_t<T>>::create(std::forward<Args>(args)...));
     }
 }
 
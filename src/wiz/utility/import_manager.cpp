@@ -1,3 +1,6 @@
+#include <string>
+#include <vector>
+
 #include <wiz/utility/text.h>
 #include <wiz/utility/path.h>
 #include <wiz/utility/reader.h>
@@ -37,10 +40,11 @@ namespace wiz {
 
         reader = nullptr;
 
+        canonicalPath = getCanonicalPath(attemptedPath, importOptions);
+
         if (attemptedPath.startsWith("<"_sv) && attemptedPath.endsWith(">"_sv)) {
-            displayPath = canonicalPath = attemptedPath;
+            displayPath = canonicalPath;
         } else {
-            canonicalPath = stringPool->intern(path::toNormalizedAbsolute(StringView(attemptedPath.toString() + (appendExtension && !attemptedPath.endsWith(StringView(SourceExtension)) ? SourceExtension : ""))));
             displayPath = StringView();
 
             if (startPath.getLength() != 0) {
@@ -103,4 +107,44 @@ namespace wiz {
         canonicalPath = StringView();
         return ImportResult::Failed;
     }
+
+    bool ImportManager::findModule(StringView fromPath, StringView originalPath, ImportOptions importOptions, StringView& canonicalPath, std::unique_ptr<Reader>& reader) {
+        const auto allowShellResources = importOptions.has<ImportOptionType::AllowShellResources>();
+
+        // Same search order as importModule.
+        std::vector<std::string> attemptedPaths;
+        attemptedPaths.push_back(path::getDirectory(fromPath).toString() + "/" + originalPath.toString());
+
+        if (!originalPath.startsWith("./"_sv) && !originalPath.startsWith("../"_sv)) {
+            for (const auto& dir : importDirs) {
+                const auto sanitizedDir = dir.findLastOf("/\\"_sv) >= dir.getLength()
+                    ? path::getDirectory(dir)
+                    : dir;
+
+                attemptedPaths.push_back(sanitizedDir.toString() + "/" + originalPath.toString());
+            }
+        }
+
+        for (const auto& attemptedPath : attemptedPaths) {
+            canonicalPath = getCanonicalPath(StringView(attemptedPath), importOptions);
+            reader = resourceManager->openReader(canonicalPath, allowShellResources);
+            if (reader != nullptr && reader->isOpen()) {
+                return true;
+            }
+        }
+
+        canonicalPath = StringView();
+        reader = nullptr;
+        return false;
+    }
+
+    StringView ImportManager::getCanonicalPath(StringView attemptedPath, ImportOptions importOptions) {
+        const auto appendExtension = importOptions.has<ImportOptionType::AppendExtension>();
+
+        if (attemptedPath.startsWith("<"_sv) && attemptedPath.endsWith(">"_sv)) {
+            return stringPool->intern(attemptedPath);
+        } else {
+            return stringPool->intern(path::toNormalizedAbsolute(StringView(attemptedPath.toString() + (appendExtension && !attemptedPath.endsWith(StringView(SourceExtension)) ? SourceExtension : ""))));
+        }
+    }
 }
\ No newline at end of file
@@ -34,7 +34,13 @@ namespace wiz {
             ImportResult attemptRelativeImport(StringView originalPath, ImportOptions importOptions, StringView& displayPath, StringView& canonicalPath, std::unique_ptr<Reader>& reader);
             ImportResult importModule(StringView originalPath, ImportOptions importOptions, StringView& displayPath, StringView& canonicalPath, std::unique_ptr<Reader>& reader);
 
+            // Finds the module that importModule would pick for an import appearing in the file at fromPath, and opens it.
+            // Unlike importModule, this doesn't depend on or change the current path or the set of already-imported modules.
+            bool findModule(StringView fromPath, StringView originalPath, ImportOptions importOptions, StringView& canonicalPath, std::unique_ptr<Reader>& reader);
+
         private:
+            StringView getCanonicalPath(StringView attemptedPath, ImportOptions importOptions);
+
             StringPool* stringPool;
             ResourceManager* resourceManager;
             ArrayView<StringView> importDirs;
@@ -14,6 +14,12 @@
 #include <iostream>
 #endif
 
+// Where the compiler has a native 128-bit integer, use it for the operations that are expensive to do by hand.
+// Otherwise, values that fit in 64 bits are handled with plain 64-bit arithmetic when it can't overflow.
+#if defined(__SIZEOF_INT128__) && !defined(WIZ_UTILITY_INT128_NO_NATIVE)
+#define WIZ_UTILITY_INT128_NATIVE
+#endif
+
 namespace wiz {
     struct Int128 {
         static_assert(sizeof(int) <= sizeof(std::uint64_t), "wiz::Int128(int) constructor assumes sizeof(int) <= sizeof(std::uint64_t) currently.");
@@ -28,31 +34,31 @@ namespace wiz {
 
         explicit Int128(signed char value)
         : low(value < 0
-            ? (((static_cast<std::uint64_t>(-value) ^ UCHAR_MAX) + 1) | (UINT64_MAX &~ static_cast<std::uint64_t>(UCHAR_MAX)))
+            ? ((((0 - static_cast<std::uint64_t>(value)) ^ UCHAR_MAX) + 1) | (UINT64_MAX &~ static_cast<std::uint64_t>(UCHAR_MAX)))
             : static_cast<std::uint64_t>(value)),
         high(value < 0 ? UINT64_MAX : 0) {}
 
         explicit Int128(short value)
         : low(value < 0
-            ? (((static_cast<std::uint64_t>(-value) ^ USHRT_MAX) + 1) | (UINT64_MAX &~ static_cast<std::uint64_t>(USHRT_MAX)))
+            ? ((((0 - static_cast<std::uint64_t>(value)) ^ USHRT_MAX) + 1) | (UINT64_MAX &~ static_cast<std::uint64_t>(USHRT_MAX)))
             : static_cast<std::uint64_t>(value)),
         high(value < 0 ? UINT64_MAX : 0) {}
 
         explicit Int128(int value)
         : low(value < 0
-            ? (((static_cast<std::uint64_t>(-value) ^ UINT_MAX) + 1) | (UINT64_MAX &~ static_cast<std::uint64_t>(UINT_MAX)))
+            ? ((((0 - static_cast<std::uint64_t>(value)) ^ UINT_MAX) + 1) | (UINT64_MAX &~ static_cast<std::uint64_t>(UINT_MAX)))
             : static_cast<std::uint64_t>(value)),
         high(value < 0 ? UINT64_MAX : 0) {}
 
         explicit Int128(long value)
         : low(value < 0
-            ? (((static_cast<std::uint64_t>(-value) ^ ULONG_MAX) + 1) | (UINT64_MAX &~ static_cast<std::uint64_t>(ULONG_MAX)))
+            ? ((((0 - static_cast<std::uint64_t>(value)) ^ ULONG_MAX) + 1) | (UINT64_MAX &~ static_cast<std::uint64_t>(ULONG_MAX)))
             : static_cast<std::uint64_t>(value)),
         high(value < 0 ? UINT64_MAX : 0) {}
 
         explicit Int128(long long value)
         : low(value < 0
-            ? (((static_cast<std::uint64_t>(-value) ^ ULLONG_MAX) + 1) | (UINT64_MAX &~ static_cast<std::uint64_t>(ULLONG_MAX)))
+            ? ((((0 - static_cast<std::uint64_t>(value)) ^ ULLONG_MAX) + 1) | (UINT64_MAX &~ static_cast<std::uint64_t>(ULLONG_MAX)))
             : static_cast<std::uint64_t>(value)),
         high(value < 0 ? UINT64_MAX : 0) {}        
 
@@ -260,12 +266,13 @@ namespace wiz {
                 for (std::size_t i = findMostSignificantBit(); i <= 128; --i) {
                     remainder = remainder.logicalLeftShiftOnce();
                     remainder.setBit(0, getBit(i));
-                    if (remainder >= other) {
+                    // Both are unsigned here, and the divisor may have its top bit set.
+                    if (remainder.high > other.high || (remainder.high == other.high && remainder.low >= other.low)) {
                         remainder -= other;
                         quotient.setBit(i, true);
                     }
                 }
-                 return {quotient, remainder};
+                return {quotient, remainder};
             }
         }
 
@@ -309,6 +316,38 @@ namespace wiz {
             return index;
         }
 
+        bool isInt64() const {
+            return isNegative()
+                ? high == UINT64_MAX && (low & 0x8000000000000000) != 0
+                : high == 0 && (low & 0x8000000000000000) == 0;
+        }
+
+        bool isInt32() const {
+            return isInt64() && toInt64() >= INT32_MIN && toInt64() <= INT32_MAX;
+        }
+
+        std::int64_t toInt64() const {
+            return static_cast<std::int64_t>(low);
+        }
+
+        static Int128 fromInt64(std::int64_t value) {
+            return Int128(static_cast<std::uint64_t>(value), value < 0 ? UINT64_MAX : 0);
+        }
+
+#ifdef WIZ_UTILITY_INT128_NATIVE
+        __extension__ typedef __int128 NativeType;
+        __extension__ typedef unsigned __int128 NativeUnsignedType;
+
+        NativeType toNative() const {
+            return static_cast<NativeType>((static_cast<NativeUnsignedType>(high) << 64) | low);
+        }
+
+        static Int128 fromNative(NativeType value) {
+            const auto bits = static_cast<NativeUnsignedType>(value);
+            return Int128(static_cast<std::uint64_t>(bits), static_cast<std::uint64_t>(bits >> 64));
+        }
+#endif
+
         bool isPowerOfTwo() const {
             return !isZero() && (*this & (*this - Int128(1))).isZero();
         }
@@ -354,6 +393,22 @@ namespace wiz {
         };
 
         std::pair<CheckedArithmeticResult, Int128> checkedAdd(Int128 other) const {
+#ifdef WIZ_UTILITY_INT128_NATIVE
+            NativeType result;
+            if (__builtin_add_overflow(toNative(), other.toNative(), &result)) {
+                return {CheckedArithmeticResult::OverflowError, zero()};
+            }
+            return {CheckedArithmeticResult::Success, fromNative(result)};
+#else
+            // When the sum also fits in 64 bits, there's no need to look at the high halves.
+            if (isInt64() && other.isInt64()) {
+                const auto a = toInt64();
+                const auto b = other.toInt64();
+                if (b >= 0 ? a <= INT64_MAX - b : a >= INT64_MIN - b) {
+                    return {CheckedArithmeticResult::Success, fromInt64(a + b)};
+                }
+            }
+
             if (isNegative()) {
                 if (other.isNegative() && *this < minValue() - other) {
                     return {CheckedArithmeticResult::OverflowError, zero()};
@@ -364,9 +419,25 @@ namespace wiz {
                 }
             }
             return {CheckedArithmeticResult::Success, *this + other};
+#endif
         }
 
         std::pair<CheckedArithmeticResult, Int128> checkedSubtract(Int128 other) const {
+#ifdef WIZ_UTILITY_INT128_NATIVE
+            NativeType result;
+            if (__builtin_sub_overflow(toNative(), other.toNative(), &result)) {
+                return {CheckedArithmeticResult::OverflowError, zero()};
+            }
+            return {CheckedArithmeticResult::Success, fromNative(result)};
+#else
+            if (isInt64() && other.isInt64()) {
+                const auto a = toInt64();
+                const auto b = other.toInt64();
+                if (b >= 0 ? a >= INT64_MIN + b : a <= INT64_MAX + b) {
+                    return {CheckedArithmeticResult::Success, fromInt64(a - b)};
+                }
+            }
+
             if (isNegative()) {
                 if (!other.isNegative() && *this < minValue() + other) {
                     return {CheckedArithmeticResult::OverflowError, zero()};
@@ -377,6 +448,7 @@ namespace wiz {
                 }
             }
             return {CheckedArithmeticResult::Success, *this - other};
+#endif
         }
 
         std::pair<CheckedArithmeticResult, Int128> checkedMultiply(Int128 other) const {
@@ -385,6 +457,17 @@ namespace wiz {
                 return {CheckedArithmeticResult::Success, Int128()};
             }
 
+            // Products of small enough operands can't overflow, and don't need the division-based limit checks below.
+#ifdef WIZ_UTILITY_INT128_NATIVE
+            if (isInt64() && other.isInt64()) {
+                return {CheckedArithmeticResult::Success, fromNative(static_cast<NativeType>(toInt64()) * other.toInt64())};
+            }
+#else
+            if (isInt32() && other.isInt32()) {
+                return {CheckedArithmeticResult::Success, fromInt64(toInt64() * other.toInt64())};
+            }
+#endif
+
             if (isNegative()) {
                 if (other.isNegative()) {
                     if (other < maxValue() / *this) {
@@ -502,6 +585,9 @@ namespace wiz {
         }
 
         bool operator <(Int128 other) const {
+#ifdef WIZ_UTILITY_INT128_NATIVE
+            return toNative() < other.toNative();
+#else
             if (isNegative()) {
                 if (other.isNegative()) {
                     return high < other.high
@@ -517,6 +603,7 @@ namespace wiz {
                         || (high == other.high && low < other.low);
                 }
             }
+#endif
         }
 
         bool operator <=(Int128 other) const {
@@ -611,9 +698,14 @@ namespace wiz {
                 return *this;
             } else if (isZero() || other.isZero()) {
                 return Int128();
-            } else if (((high == 0 || high == UINT64_MAX) && low <= UINT32_MAX) && ((other.high == 0 || other.high == UINT64_MAX) && other.low <= UINT32_MAX)) {
-                return Int128(low * other.low, (high == UINT64_MAX) != (other.high == UINT64_MAX) ? UINT64_MAX : 0);
             } else {
+#ifdef WIZ_UTILITY_INT128_NATIVE
+                return fromNative(static_cast<NativeType>(static_cast<NativeUnsignedType>(toNative()) * static_cast<NativeUnsignedType>(other.toNative())));
+#else
+                if (isInt32() && other.isInt32()) {
+                    return fromInt64(toInt64() * other.toInt64());
+                }
+
                 // First do a 64 x 64 -> 128-bit multiply.
                 //
                 // a * b
@@ -640,14 +732,34 @@ namespace wiz {
                 const auto z = ah * bl;
                 const auto w = ah * bh;
                 return Int128(x, 0) + Int128(y << 32, y >> 32) + Int128(z << 32, z >> 32) + Int128(0, w + low * other.high + high * other.low);
+#endif
             }
         }
 
+        // Division by zero, and by -1 (which overflows for the minimum value), are left to the portable version.
         Int128 operator /(Int128 other) const {
+#ifdef WIZ_UTILITY_INT128_NATIVE
+            if (!other.isZero() && other != Int128(UINT64_MAX, UINT64_MAX)) {
+                return fromNative(toNative() / other.toNative());
+            }
+#else
+            if (isInt64() && other.isInt64() && !other.isZero() && other.toInt64() != -1) {
+                return fromInt64(toInt64() / other.toInt64());
+            }
+#endif
             return divisionWithRemainder(other).first;
         }
 
         Int128 operator %(Int128 other) const {
+#ifdef WIZ_UTILITY_INT128_NATIVE
+            if (!other.isZero() && other != Int128(UINT64_MAX, UINT64_MAX)) {
+                return fromNative(toNative() % other.toNative());
+            }
+#else
+            if (isInt64() && other.isInt64() && !other.isZero() && other.toInt64() != -1) {
+                return fromInt64(toInt64() % other.toInt64());
+            }
+#endif
             return divisionWithRemainder(other).second;
         }
 
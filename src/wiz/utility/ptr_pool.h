@@ -2,6 +2,7 @@
 #define WIZ_UTILITY_INSTANCE_POOL_H
 
 #include <vector>
+#include <algorithm>
 
 #include <wiz/utility/array_view.h>
 #include <wiz/utility/unique_ptr.h>
@@ -26,6 +27,12 @@ namespace wiz {
                 instances_.erase(instances_.begin() + index);
             }
 
+            // Removes every instance matching the predicate in a single pass, preserving the order of the remaining instances.
+            template <typename Predicate>
+            void removeIf(Predicate predicate) {
+                instances_.erase(std::remove_if(instances_.begin(), instances_.end(), predicate), instances_.end());
+            }
+
             WIZ_FORCE_INLINE void clear() {
                 instances_.clear();
             }
@@ -1,9 +1,68 @@
+#if (defined(__APPLE__) || defined(__unix__)) && !defined(__EMSCRIPTEN__)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #define WIZ_MMAP
+#endif
+
 #include <algorithm>
 #include <iterator>
+#include <utility>
 
 #include <wiz/utility/reader.h>
 
 namespace wiz {
+    namespace {
+        bool readBufferLine(StringView buffer, std::size_t& offset, StringView& result) {
+            const auto length = buffer.getLength();
+            if (offset >= length) {
+                return false;
+            }
+
+            const auto start = offset;
+            offset = buffer.findFirstOf("\r\n"_sv, offset);
+
+            if (offset >= length) {
+                offset = length;
+            } else {
+                if (offset < length - 1
+                && buffer[offset] == '\r'
+                && buffer[offset + 1] == '\n') {
+                    offset++;
+                }
+                offset++;
+            }
+
+            result = buffer.sub(start, offset - start);
+            return true;
+        }
+
+        std::string readBufferFully(StringView buffer, std::size_t& offset) {
+            if (offset >= buffer.getLength()) {
+                return "";
+            }
+            const auto origin = offset;
+            offset = buffer.getLength();
+            return buffer.sub(origin).toString();
+        }
+
+        bool viewBufferFully(StringView buffer, std::size_t& offset, StringView& result) {
+            if (offset >= buffer.getLength()) {
+                result = StringView();
+            } else {
+                result = buffer.sub(offset);
+            }
+            offset = buffer.getLength();
+            return true;
+        }
+    }
+
+    bool Reader::viewFully(StringView& result) {
+        static_cast<void>(result);
+        return false;
+    }
+
     FileReader::FileReader()
     : filename(),
     file(nullptr, [](std::FILE*) { return 0; }) {}
@@ -29,12 +88,13 @@ namespace wiz {
         return file != nullptr;
     }
 
-    bool FileReader::readLine(std::string& result) {
+    bool FileReader::readLine(StringView& result) {
         if (!isOpen()) {
             return false;
         }
 
-        result.clear();
+        auto& line = lineBuffer;
+        line.clear();
 
         auto f = file.get();
         bool eol = false;
@@ -44,17 +104,18 @@ namespace wiz {
             if (!std::fgets(buffer, sizeof(buffer), f)) {
                 eof = true;
             } else {
-                result.append(buffer);
+                line.append(buffer);
 
-                const auto len = result.length();
-                if ((len > 2 && result[len - 2] == '\r' && result[len - 1] == '\n')
-                || (len >= 1 && (result[len - 1] == '\r' || result[len - 1] == '\n'))) {
+                const auto len = line.length();
+                if ((len > 2 && line[len - 2] == '\r' && line[len - 1] == '\n')
+                || (len >= 1 && (line[len - 1] == '\r' || line[len - 1] == '\n'))) {
                     eol = true;
                 }
             }
         }
 
-        return !eof || result.length() > 0;
+        result = StringView(line);
+        return !eof || line.length() > 0;
     }
 
     std::string FileReader::readFully() {
@@ -85,8 +146,11 @@ namespace wiz {
         }
     }
 
-    MemoryReader::MemoryReader(const std::string& buffer)
-    : buffer(buffer), offset(0) {}
+    MemoryReader::MemoryReader(std::string buffer)
+    : ownedBuffer(std::move(buffer)), buffer(ownedBuffer), offset(0) {}
+
+    MemoryReader::MemoryReader(StringView buffer)
+    : ownedBuffer(), buffer(buffer), offset(0) {}
 
     MemoryReader::~MemoryReader() {}
 
@@ -94,38 +158,68 @@ namespace wiz {
         return true;
     }
 
-    bool MemoryReader::readLine(std::string& result) {
-        if (offset >= buffer.length()) {
-            return false;
+    bool MemoryReader::readLine(StringView& result) {
+        return readBufferLine(buffer, offset, result);
+    }
+
+    std::string MemoryReader::readFully() {
+        return readBufferFully(buffer, offset);
+    }
+
+    bool MemoryReader::viewFully(StringView& result) {
+        return viewBufferFully(buffer, offset, result);
+    }
+
+    MappedFileReader::MappedFileReader(StringView filename)
+    : open(false), mapping(nullptr), buffer(), offset(0) {
+#ifdef WIZ_MMAP
+        const auto fd = ::open(filename.getData(), O_RDONLY);
+        if (fd < 0) {
+            return;
         }
-     
-        bool eof = false;
-        const auto old = offset;
-        offset = buffer.find_first_of("\r\n", offset);
-     
-        if (offset >= buffer.length()) {
-            offset = buffer.length() - 1;
-            eof = true;
-        } else {
-            if (offset < buffer.length() - 1
-            && buffer[offset] == '\r'
-            && buffer[offset + 1] == '\n') {
-                offset++;
+
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+            const auto size = static_cast<std::size_t>(info.st_size);
+            if (size == 0) {
+                open = true;
+            } else {
+                const auto result = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (result != MAP_FAILED) {
+                    open = true;
+                    mapping = result;
+                    buffer = StringView(static_cast<const char*>(result), size);
+                }
             }
         }
-     
-        offset++;
-        result = buffer.substr(old, offset - old);
 
-        return !eof || result.length() > 0;
+        ::close(fd);
+#else
+        static_cast<void>(filename);
+#endif
     }
 
-    std::string MemoryReader::readFully() {
-        if (offset >= buffer.length()) {
-            return "";
+    MappedFileReader::~MappedFileReader() {
+#ifdef WIZ_MMAP
+        if (mapping != nullptr) {
+            ::munmap(mapping, buffer.getLength());
         }
-        const auto origin = offset;
-        offset = buffer.length();
-        return buffer.substr(origin, buffer.length());
+#endif
+    }
+
+    bool MappedFileReader::isOpen() const {
+        return open;
+    }
+
+    bool MappedFileReader::readLine(StringView& result) {
+        return readBufferLine(buffer, offset, result);
+    }
+
+    std::string MappedFileReader::readFully() {
+        return readBufferFully(buffer, offset);
+    }
+
+    bool MappedFileReader::viewFully(StringView& result) {
+        return viewBufferFully(buffer, offset, result);
     }
-}
\ No newline at end of file
+}
@@ -13,8 +13,15 @@ namespace wiz {
         public:
             virtual ~Reader() {}
             virtual bool isOpen() const = 0;
-            virtual bool readLine(std::string& result) = 0;
+
+            // Reads the next line, including its line terminator.
+            // The resulting view is valid until the next readLine call, or until the reader is destroyed.
+            virtual bool readLine(StringView& result) = 0;
             virtual std::string readFully() = 0;
+
+            // Views the rest of the input without copying it, if the reader already holds all of it in memory.
+            // The resulting view is valid until the reader is destroyed. Returns false if the input must be read instead.
+            virtual bool viewFully(StringView& result);
     };
 
     class FileReader : public Reader {
@@ -28,7 +35,7 @@ namespace wiz {
             FileReader& operator =(FileReader&& reader) = default;
 
             virtual bool isOpen() const override;
-            virtual bool readLine(std::string& result) override;
+            virtual bool readLine(StringView& result) override;
             virtual std::string readFully() override;
 
         private:
@@ -37,18 +44,50 @@ namespace wiz {
 
             StringView filename;
             std::unique_ptr<std::FILE, decltype(&std::fclose)> file;
+            std::string lineBuffer;
     };
 
     class MemoryReader : public Reader {
         public:
-            MemoryReader(const std::string& buffer);
+            // Takes ownership of the buffer.
+            MemoryReader(std::string buffer);
+            // Reads from a buffer owned by the caller, which must outlive the reader.
+            MemoryReader(StringView buffer);
             virtual ~MemoryReader() override;
             
             virtual bool isOpen() const override;
-            virtual bool readLine(std::string& result) override;
+            virtual bool readLine(StringView& result) override;
+            virtual std::string readFully() override;
+            virtual bool viewFully(StringView& result) override;
+
+        private:
+            MemoryReader(const MemoryReader&) = delete;
+            MemoryReader& operator=(const MemoryReader&) = delete;
+
+            std::string ownedBuffer;
+            StringView buffer;
+            std::size_t offset;
+    };
+
+    // Maps an entire file into memory, so that lines can be handed out without copying.
+    // isOpen() is false if the file could not be mapped, or if the platform has no support for file mappings.
+    class MappedFileReader : public Reader {
+        public:
+            MappedFileReader(StringView filename);
+            virtual ~MappedFileReader() override;
+
+            virtual bool isOpen() const override;
+            virtual bool readLine(StringView& result) override;
             virtual std::string readFully() override;
+            virtual bool viewFully(StringView& result) override;
+
         private:
-            std::string buffer;
+            MappedFileReader(const MappedFileReader&) = delete;
+            MappedFileReader& operator=(const MappedFileReader&) = delete;
+
+            bool open;
+            void* mapping;
+            StringView buffer;
             std::size_t offset;
     };
 }
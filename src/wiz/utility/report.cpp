@@ -19,12 +19,18 @@ namespace wiz {
     Report::Report(std::unique_ptr<Logger> logger)
     : logger(std::move(logger)), aborted(false), errors(0), previousFlags() {}
 
+    Report::Report()
+    : logger(), aborted(false), errors(0), previousFlags() {}
+
     Report::~Report() {}
 
     void Report::error(const std::string& message, const SourceLocation& location, ReportErrorFlags flags) {
         if (!aborted) {
-            auto severity = getSeverity(flags, previousFlags);
-            logger->error(location, severity, message);
+            if (logger != nullptr) {
+                logger->error(location, getSeverity(flags, previousFlags), message);
+            } else {
+                deferredErrors.push_back(DeferredError(message, location, flags));
+            }
 
             bool aborting = flags.has<ReportErrorFlagType::Fatal>() || previousFlags.has<ReportErrorFlagType::Fatal>();
             previousFlags = flags | (previousFlags.intersect<ReportErrorFlagType::Fatal>());
@@ -36,7 +42,9 @@ namespace wiz {
             }
 
             if (errors >= MaxErrors) {
-                logger->error(location, ReportErrorSeverity::Fatal, "too many errors encountered. stopping.");
+                if (logger != nullptr) {
+                    logger->error(location, ReportErrorSeverity::Fatal, "too many errors encountered. stopping.");
+                }
                 aborting = true;
             }
 
@@ -58,11 +66,15 @@ namespace wiz {
     }
 
     void Report::notice(const std::string& message) {
-        logger->notice(message);
+        if (logger != nullptr) {
+            logger->notice(message);
+        }
     }
 
     void Report::log(const std::string& message) {
-        logger->log(message);
+        if (logger != nullptr) {
+            logger->log(message);
+        }
     }
 
     void Report::abort() {
@@ -75,4 +87,8 @@ namespace wiz {
     Logger* Report::getLogger() const {
         return logger.get();
     }
+
+    const std::vector<Report::DeferredError>& Report::getDeferredErrors() const {
+        return deferredErrors;
+    }
 }
\ No newline at end of file
@@ -4,19 +4,38 @@
 #include <stdexcept>
 #include <string>
 #include <memory>
+#include <vector>
 #include <type_traits>
 
+#include <wiz/utility/source_location.h>
 #include <wiz/utility/report_error_flags.h>
 
 namespace wiz {
     class Logger;
-    class SourceLocation;
 
     class Report {
         public:
             static const std::size_t MaxErrors = 64;
 
+            struct DeferredError {
+                DeferredError(
+                    const std::string& message,
+                    const SourceLocation& location,
+                    ReportErrorFlags flags)
+                : message(message),
+                location(location),
+                flags(flags) {}
+
+                std::string message;
+                SourceLocation location;
+                ReportErrorFlags flags;
+            };
+
             Report(std::unique_ptr<Logger> logger);
+            // Creates a report that holds onto its errors instead of logging them.
+            // Lets work done on another thread pass its errors along to the main report later, in a deterministic order.
+            // Notices and logs are dropped.
+            Report();
             ~Report();
 
             void error(const std::string& message, const SourceLocation& location, ReportErrorFlags flags = ReportErrorFlags());
@@ -27,6 +46,7 @@ namespace wiz {
             bool alive() const;
 
             Logger* getLogger() const;
+            const std::vector<DeferredError>& getDeferredErrors() const;
 
         private:
             Report(const Report&) = delete;
@@ -38,6 +58,7 @@ namespace wiz {
             bool aborted;
             std::size_t errors;
             ReportErrorFlags previousFlags;
+            std::vector<DeferredError> deferredErrors;
     };
 }
 #endif
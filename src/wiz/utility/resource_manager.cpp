@@ -19,6 +19,12 @@ namespace wiz {
 #endif
         {
             static_cast<void>(allowShellResources);
+
+            auto mappedFile = std::make_unique<MappedFileReader>(filename);
+            if (mappedFile->isOpen()) {
+                return mappedFile;
+            }
+
             file = FileReader(filename);
         }
 
@@ -41,7 +47,7 @@ namespace wiz {
         
         const auto match = readBuffers.find(filename);
         if (match != readBuffers.end()) {
-            return std::make_unique<MemoryReader>(match->second);
+            return std::make_unique<MemoryReader>(StringView(match->second));
         }
         return nullptr;
     }
@@ -0,0 +1,81 @@
+#ifndef WIZ_UTILITY_SMALL_VECTOR_H
+#define WIZ_UTILITY_SMALL_VECTOR_H
+
+#include <cstddef>
+#include <vector>
+#include <type_traits>
+
+#include <wiz/utility/macros.h>
+
+namespace wiz {
+    // A vector that keeps up to N items inline, and only allocates once it grows past that.
+    // Limited to trivially copyable items, which is all it is needed for (pointers, mostly).
+    template <typename T, std::size_t N>
+    class SmallVector {
+        static_assert(std::is_trivially_copyable<T>::value, "SmallVector items must be trivially copyable");
+        static_assert(N > 0, "SmallVector must have room for at least one inline item");
+
+        public:
+            SmallVector()
+            : inlineItems(),
+            length(0) {}
+
+            WIZ_FORCE_INLINE std::size_t size() const {
+                return length;
+            }
+
+            WIZ_FORCE_INLINE bool empty() const {
+                return length == 0;
+            }
+
+            WIZ_FORCE_INLINE T* begin() {
+                return heapItems.empty() ? inlineItems : heapItems.data();
+            }
+
+            WIZ_FORCE_INLINE T* end() {
+                return begin() + length;
+            }
+
+            WIZ_FORCE_INLINE const T* begin() const {
+                return heapItems.empty() ? inlineItems : heapItems.data();
+            }
+
+            WIZ_FORCE_INLINE const T* end() const {
+                return begin() + length;
+            }
+
+            WIZ_FORCE_INLINE T& operator [](std::size_t index) {
+                return begin()[index];
+            }
+
+            WIZ_FORCE_INLINE const T& operator [](std::size_t index) const {
+                return begin()[index];
+            }
+
+            void push_back(const T& value) {
+                if (heapItems.empty()) {
+                    if (length < N) {
+                        inlineItems[length++] = value;
+                        return;
+                    }
+                    heapItems.assign(inlineItems, inlineItems + length);
+                }
+
+                heapItems.push_back(value);
+                ++length;
+            }
+
+            // Keeps any heap capacity around, but goes back to using the inline items until it is needed again.
+            void clear() {
+                heapItems.clear();
+                length = 0;
+            }
+
+        private:
+            T inlineItems[N];
+            std::size_t length;
+            std::vector<T> heapItems;
+    };
+}
+
+#endif
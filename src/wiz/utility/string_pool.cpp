@@ -0,0 +1,181 @@
+#include <new>
+#include <cstring>
+#include <functional>
+#include <utility>
+
+#ifdef WIZ_DEBUG
+#include <map>
+#include <mutex>
+#endif
+
+#include <wiz/utility/string_pool.h>
+
+namespace wiz {
+    namespace {
+        const std::size_t ChunkSize = 64 * 1024;
+        const std::size_t InitialSlotCount = 1024;
+
+        std::size_t alignEntrySize(std::size_t size, std::size_t alignment) {
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+#ifdef WIZ_DEBUG
+        // The start and end of every chunk of every StringPool, keyed by start. Pools may live on different threads.
+        struct DebugChunkRegistry {
+            std::mutex mutex;
+            std::map<const char*, const char*> chunks;
+        };
+
+        DebugChunkRegistry& getDebugChunkRegistry() {
+            static DebugChunkRegistry registry;
+            return registry;
+        }
+#endif
+    }
+
+    StringPool::StringPool()
+    : chunkPosition(nullptr),
+    chunkRemaining(0),
+    slots(InitialSlotCount, nullptr),
+    entryCount(0) {}
+
+    StringPool::~StringPool() {
+#ifdef WIZ_DEBUG
+        for (const auto& chunk : chunks) {
+            unregisterChunk(chunk.get());
+        }
+#endif
+    }
+
+    StringView StringPool::intern(StringView source) {
+        return intern(source, std::hash<StringView>()(source));
+    }
+
+    StringView StringPool::intern(StringView source, std::size_t hash) {
+        const auto length = source.getLength();
+        const auto mask = slots.size() - 1;
+
+        auto index = hash & mask;
+        while (const auto entry = slots[index]) {
+            if (entry->hash == hash
+            && entry->length == length
+            && std::memcmp(entry->getData(), source.getData(), length) == 0) {
+                return StringView(entry->getData(), length);
+            }
+            index = (index + 1) & mask;
+        }
+
+        auto entry = allocateEntry(length);
+        entry->hash = hash;
+        entry->id = entryCount;
+        entry->length = length;
+
+        auto data = const_cast<char*>(entry->getData());
+        std::memcpy(data, source.getData(), length);
+        data[length] = '\0';
+
+        slots[index] = entry;
+        entryCount++;
+
+        // Keep the table at most half full.
+        if (entryCount * 2 > slots.size()) {
+            grow();
+        }
+
+        return StringView(entry->getData(), length);
+    }
+
+    std::vector<StringView> StringPool::merge(const StringPool& other) {
+        std::vector<const Entry*> entries(other.entryCount, nullptr);
+        for (const auto entry : other.slots) {
+            if (entry != nullptr) {
+                entries[entry->id] = entry;
+            }
+        }
+
+        std::vector<StringView> result;
+        result.reserve(entries.size());
+        for (const auto entry : entries) {
+            result.push_back(intern(StringView(entry->getData(), entry->length), entry->hash));
+        }
+        return result;
+    }
+
+    StringPool::Entry* StringPool::allocateEntry(std::size_t length) {
+        const auto size = alignEntrySize(sizeof(Entry) + length + 1, alignof(Entry));
+
+        if (size > chunkRemaining) {
+            // Long strings get a chunk of their own, so that the rest of the current chunk stays usable.
+            if (size > ChunkSize / 4) {
+                return new (allocateChunk(size)) Entry();
+            }
+
+            chunkPosition = allocateChunk(ChunkSize);
+            chunkRemaining = ChunkSize;
+        }
+
+        const auto entry = new (chunkPosition) Entry();
+        chunkPosition += size;
+        chunkRemaining -= size;
+        return entry;
+    }
+
+    char* StringPool::allocateChunk(std::size_t size) {
+        chunks.push_back(std::make_unique<char[]>(size));
+#ifdef WIZ_DEBUG
+        registerChunk(chunks.back().get(), size);
+#endif
+        return chunks.back().get();
+    }
+
+#ifdef WIZ_DEBUG
+    bool StringPool::isInterned(StringView view) {
+        const auto data = view.getData();
+        auto& registry = getDebugChunkRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        auto match = registry.chunks.upper_bound(data);
+        if (match == registry.chunks.begin()) {
+            return false;
+        }
+        --match;
+
+        // There must be room for a header in front of the text, and the text and its terminator must fit after it.
+        if (data < match->first + sizeof(Entry) || data + view.getLength() >= match->second) {
+            return false;
+        }
+
+        const auto entry = reinterpret_cast<const Entry*>(data) - 1;
+        return entry->length == view.getLength() && data[view.getLength()] == '\0';
+    }
+
+    void StringPool::registerChunk(const char* start, std::size_t size) {
+        auto& registry = getDebugChunkRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.chunks[start] = start + size;
+    }
+
+    void StringPool::unregisterChunk(const char* start) {
+        auto& registry = getDebugChunkRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.chunks.erase(start);
+    }
+#endif
+
+    void StringPool::grow() {
+        std::vector<const Entry*> resized(slots.size() * 2, nullptr);
+        const auto mask = resized.size() - 1;
+
+        for (const auto entry : slots) {
+            if (entry != nullptr) {
+                auto index = entry->hash & mask;
+                while (resized[index] != nullptr) {
+                    index = (index + 1) & mask;
+                }
+                resized[index] = entry;
+            }
+        }
+
+        slots = std::move(resized);
+    }
+}
@@ -1,18 +1,25 @@
 #ifndef WIZ_UTILITY_STRING_POOL_H
 #define WIZ_UTILITY_STRING_POOL_H
 
+#include <cassert>
 #include <cstddef>
 #include <string>
 #include <vector>
-#include <unordered_set>
 #include <memory>
+#include <unordered_map>
 
 #include <wiz/utility/macros.h>
 #include <wiz/utility/string_view.h>
 
 namespace wiz {
+    // Interns strings so that equal text always yields the same StringView.
+    // Interned text is stored contiguously in large chunks that are never moved or freed until the pool is destroyed,
+    // and is always followed by a null terminator.
     class StringPool {
         public:
+            StringPool();
+            ~StringPool();
+
             WIZ_FORCE_INLINE StringView intern(const char* source) {
                 return intern(StringView(source));
             }
@@ -21,24 +28,91 @@ namespace wiz {
                 return intern(StringView(source));
             }
 
-            StringView intern(StringView source) {
-                const auto match = views.find(source);
+            StringView intern(StringView source);
 
-                if (match != views.end()) {
-                    return *match;
-                } else {
-                    strings.push_back(std::make_unique<std::string>(source.getData(), source.getLength()));
+            // Interns text whose hash is already known, such as a view interned by another StringPool.
+            // The hash must match the one intern() would compute for the same text.
+            StringView intern(StringView source, std::size_t hash);
 
-                    const auto view = StringView(*strings.back());
-                    views.insert(view);
-                    return view;
-                }
+            // Interns every string of another pool, in the order that pool first interned them, reusing its stored hashes.
+            // Returns the resulting views, indexed by their symbol ID in the other pool.
+            std::vector<StringView> merge(const StringPool& other);
+
+            // Returns a dense ID for interned text, counting up from 0 in the order that strings were first interned.
+            // The view must have been returned by intern() on a StringPool.
+            WIZ_FORCE_INLINE static std::size_t getSymbolId(StringView interned) {
+                return getEntry(interned)->id;
+            }
+
+            // Returns the hash that was computed when the text was interned.
+            // The view must have been returned by intern() on a StringPool.
+            WIZ_FORCE_INLINE static std::size_t getHash(StringView interned) {
+                return getEntry(interned)->hash;
+            }
+
+            std::size_t getSymbolCount() const {
+                return entryCount;
             }
 
         private:
-            std::vector<std::unique_ptr<std::string>> strings;
-            std::unordered_set<StringView> views;
+            StringPool(const StringPool&) = delete;
+            StringPool& operator=(const StringPool&) = delete;
+
+            // Header stored in a chunk directly in front of the characters of each interned string.
+            struct Entry {
+                std::size_t hash;
+                std::size_t id;
+                std::size_t length;
+
+                const char* getData() const {
+                    return reinterpret_cast<const char*>(this + 1);
+                }
+            };
+
+            static const Entry* getEntry(StringView interned) {
+#ifdef WIZ_DEBUG
+                assert(isInterned(interned) && "StringView passed to StringPool::getEntry() was not returned by StringPool::intern()");
+#endif
+                return reinterpret_cast<const Entry*>(interned.getData()) - 1;
+            }
+
+#ifdef WIZ_DEBUG
+            // Checks that a view is the full text of an entry in the chunks of some live StringPool.
+            // The header in front of the text is only read once the view is known to point inside a chunk.
+            static bool isInterned(StringView view);
+            static void registerChunk(const char* start, std::size_t size);
+            static void unregisterChunk(const char* start);
+#endif
+
+            Entry* allocateEntry(std::size_t length);
+            char* allocateChunk(std::size_t size);
+            void grow();
+
+            std::vector<std::unique_ptr<char[]>> chunks;
+            char* chunkPosition;
+            std::size_t chunkRemaining;
+
+            // Open-addressed hash table with a power-of-two number of slots.
+            std::vector<const Entry*> slots;
+            std::size_t entryCount;
     };
+
+    // Hashes interned text by the hash stored when it was interned, and compares it by address.
+    // Every key and every lookup must be a view returned by StringPool::intern(). Debug builds check this through getHash().
+    struct InternedStringHash {
+        std::size_t operator()(StringView interned) const {
+            return StringPool::getHash(interned);
+        }
+    };
+
+    struct InternedStringEqual {
+        bool operator()(StringView left, StringView right) const {
+            return left.getData() == right.getData();
+        }
+    };
+
+    template <typename T>
+    using InternedStringMap = std::unordered_map<StringView, T, InternedStringHash, InternedStringEqual>;
 }
 
 #endif
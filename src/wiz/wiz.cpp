@@ -1,6 +1,8 @@
 #include <memory>
+#include <chrono>
 #include <utility>
 #include <clocale>
+#include <cstdlib>
 
 #include <wiz/ast/statement.h>
 #include <wiz/ast/expression.h>
@@ -15,6 +17,7 @@
 #include <wiz/platform/platform.h>
 #include <wiz/utility/tty.h>
 #include <wiz/utility/path.h>
+#include <wiz/utility/arena.h>
 #include <wiz/utility/logger.h>
 #include <wiz/utility/reader.h>
 #include <wiz/utility/report.h>
@@ -63,6 +66,10 @@ namespace wiz {
 #endif
 
     int run(Report* report, ResourceManager* resourceManager, ArrayView<const char*> arguments) {
+        // Holds the AST and reduced expressions made during this run. Declared first, so that it outlives all of their owners.
+        Arena astArena;
+        Arena::Scope astArenaScope(&astArena);
+
         StringPool stringPool;
         PlatformCollection platformCollection;
         FormatCollection formatCollection;
@@ -84,6 +91,8 @@ namespace wiz {
             System,
             ImportDir,
             Color,
+            Jobs,
+            Stats,
             Version,
             Help,
             FromStdin,
@@ -113,6 +122,10 @@ namespace wiz {
                 "    `none` - disable text coloring.\n"
                 "    `auto` - automatically use text coloring, if support is available (default)\n"
                 "    `ansi` - force ansi escape sequences to be used for text coloring."},
+            {OptionType::Jobs, "jobs", 'j', true, "count",
+                "    reads and scans imported modules before parsing, and writes banks after compiling, on up to <count> threads. (default: 1)"},
+            {OptionType::Stats, "stats", 0, false, "",
+                "    prints statistics about the compilation after it finishes."},
             {OptionType::Version, "version", 0, false, "",
                 "    prints the current compiler version."},
             {OptionType::Help, "help", 0, false, "",
@@ -128,6 +141,8 @@ namespace wiz {
 
         bool invalidOptions = false;
         bool displayIntroMessage = true;
+        bool displayStats = false;
+        std::size_t jobCount = 1;
         const auto options = optionParser.getOptions();
 
         for (const auto& option : options) {
@@ -182,6 +197,22 @@ namespace wiz {
                     report->getLogger()->setColorSetting(setting);
                     break;
                 }
+                case OptionType::Jobs: {
+                    const auto value = option.value.toString();
+                    char* end = nullptr;
+                    const auto count = std::strtoul(value.c_str(), &end, 10);
+                    if (value.empty() || *end != '\0' || count == 0) {
+                        report->notice("invalid thread count `" + value + "` provided to `--jobs` argument.");
+                        invalidOptions = true;
+                    } else {
+                        jobCount = count;
+                    }
+                    break;
+                }
+                case OptionType::Stats: {
+                    displayStats = true;
+                    break;
+                }
                 case OptionType::FromStdin: {
                     if (inputName.getLength() == 0) {
                         inputName = "-"_sv;
@@ -287,10 +318,16 @@ namespace wiz {
         report->log(">> Parsing...");
         ImportManager importManager(&stringPool, resourceManager, ArrayView<StringView>(importDirs));
         Parser parser(&stringPool, &importManager, report);
+        parser.setJobCount(jobCount);
+
+        const auto parseStartTime = std::chrono::steady_clock::now();
+        auto program = parser.parse(inputName);
+        const auto parseDuration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - parseStartTime);
 
-        if (auto program = parser.parse(inputName)) {
+        if (program) {
             report->log(">> Compiling...");
             Compiler compiler(std::move(program), platform, &stringPool, &config, &importManager, report, std::move(defines));
+            compiler.setJobCount(jobCount);
 
             if (compiler.compile()) {
                 Format* format = nullptr;
@@ -337,6 +374,52 @@ namespace wiz {
                     dumpAddress(report, definition, output);
                 }
 #endif
+                if (displayStats) {
+                    const auto& builtins = compiler.getBuiltins();
+                    report->log(">> Stats:");
+                    report->log("  parsing: " + std::to_string(parseDuration.count()) + " ms");
+                    if (parser.getPrescannedModuleCount() != 0) {
+                        report->log("  module prescan: "
+                            + std::to_string(parser.getPrescannedModuleCount()) + " module(s) in "
+                            + std::to_string(parser.getPrescanDuration()) + " ms on up to "
+                            + std::to_string(jobCount) + " thread(s)");
+                    }
+                    report->log("  ast arena: "
+                        + std::to_string(astArena.getUsedSize() / 1024) + " KiB in "
+                        + std::to_string(astArena.getChunkCount()) + " chunk(s), "
+                        + std::to_string(astArena.getResetCount()) + " temporary reset(s)");
+                    report->log("  shared expressions: "
+                        + std::to_string(compiler.getExpressionCache().getNodeCount()) + " node(s), "
+                        + std::to_string(compiler.getExpressionCache().getHitCount()) + " reuse(s)");
+                    report->log("  interned types: "
+                        + std::to_string(compiler.getTypeTable().getNodeCount()) + " node(s), "
+                        + std::to_string(compiler.getTypeTable().getCanonicalTypeCount()) + " distinct");
+                    report->log("  let cache: "
+                        + std::to_string(compiler.getLetCacheHits()) + " hit(s), "
+                        + std::to_string(compiler.getLetCacheMisses()) + " miss(es)");
+                    report->log("  expression programs: "
+                        + std::to_string(compiler.getExpressionProgramCount()) + " compiled, "
+                        + std::to_string(compiler.getExpressionProgramEvaluations()) + " evaluation(s), "
+                        + std::to_string(compiler.getExpressionProgramFallbacks()) + " fallback(s)");
+                    report->log("  instruction selection cache: "
+                        + std::to_string(builtins.getInstructionSelectionCacheHits()) + " hit(s), "
+                        + std::to_string(builtins.getInstructionSelectionCacheMisses()) + " miss(es)");
+#ifdef WIZ_COUNT_ALLOCATIONS
+                    report->log("  instruction encoding: "
+                        + std::to_string(compiler.getEncodedInstructionCount()) + " instruction(s), "
+                        + std::to_string(compiler.getEncodingHeapAllocations()) + " heap allocation(s)");
+#else
+                    report->log("  instruction encoding: "
+                        + std::to_string(compiler.getEncodedInstructionCount()) + " instruction(s)");
+#endif
+                    report->log("  branch relaxation: "
+                        + std::to_string(compiler.getRelaxedBranchCount()) + " branch(es) promoted in "
+                        + std::to_string(compiler.getLayoutPassCount()) + " layout pass(es)");
+                    report->log("  code emission: "
+                        + std::to_string(compiler.getEmittedBankCount()) + " bank(s) written on up to "
+                        + std::to_string(jobCount) + " thread(s)");
+                }
+
                 report->notice("Done.");
                 return 0;
             }
@@ -0,0 +1,370 @@
+#!/usr/bin/env python3
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+from collections import namedtuple
+
+Benchmark = namedtuple('Benchmark', ('name', 'system', 'description', 'generate'))
+Invocation = namedtuple('Invocation', ('directory', 'arguments', 'extension'))
+
+EXAMPLES_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir, 'examples')
+
+BENCHMARKS = list()
+
+def benchmark(name, system, description):
+    def register(generate):
+        BENCHMARKS.append(Benchmark(name, system, description, generate))
+        return generate
+    return register
+
+
+
+@benchmark('redundant_goto', '6502', 'many `goto` statements that fall through to the label right after them')
+def generate_redundant_goto(scale):
+    # Each item emits 3 IR nodes (load, goto, label), and the goto is removed in the first pass of code generation.
+    banks = 4 * scale
+    items_per_bank = 10000
+
+    lines = list()
+    for b in range(banks):
+        lines.append(f'bank prg{b} @ 0x8000 : [constdata; 0x8000];')
+    lines.append('')
+
+    for b in range(banks):
+        lines.append(f'in prg{b} {{')
+        lines.append(f'    func f{b} {{')
+        for i in range(items_per_bank):
+            lines.append(f'        a = {i & 0xFF};')
+            lines.append(f'        goto l{i};')
+            lines.append(f'    l{i}:')
+        lines.append('    }')
+        lines.append('}')
+        lines.append('')
+
+    return '\n'.join(lines)
+
+
+
+@benchmark('instruction_selection', 'z80', 'many short, repetitive register and memory operations')
+def generate_instruction_selection(scale):
+    banks = 32 * scale
+    items_per_bank = 500
+
+    lines = list()
+    lines.append('bank ram @ 0xC000 : [vardata; 0x2000];')
+    for b in range(banks):
+        lines.append(f'bank rom{b} @ 0x4000 : [constdata; 0x4000];')
+    lines.append('')
+    lines.append('in ram {')
+    lines.append('    var mem : u8;')
+    lines.append('    var wmem : u16;')
+    lines.append('}')
+    lines.append('')
+
+    for b in range(banks):
+        lines.append(f'in rom{b} {{')
+        lines.append(f'    func f{b} {{')
+        for i in range(items_per_bank):
+            lines.append(f'        a = b; b = a; a = {i & 0xFF}; a += b; a = mem; mem = a;')
+            lines.append(f'        hl = {i}; hl = wmem; a = *(hl as *u8); a &= 0x0F; c = a; a ^= c;')
+        lines.append('    }')
+        lines.append('}')
+        lines.append('')
+
+    return '\n'.join(lines)
+
+
+
+@benchmark('lexer', '6502', 'several megabytes of comments, identifiers, numbers and strings that are scanned but never compiled')
+def generate_lexer(scale):
+    # `let` declarations that are never referenced are parsed but never reduced,
+    # so nearly all of the time is spent in the scanner and parser.
+    items = 40000 * scale
+
+    lines = list()
+    lines.append('bank prg @ 0x8000 : [constdata; 0x100];')
+    lines.append('')
+    for i in range(items):
+        lines.append(f'// item {i}: a line comment that is skipped by the scanner without producing any tokens')
+        lines.append(f'let generated_identifier_{i} = 0x{i & 0xFFFF:04X}_{i >> 16:X} + {i} * another_identifier_{i} - 0b1010_0101 + 12u8;')
+        lines.append(f'let generated_string_{i} = "a string literal with an escape\\n and more text after it";')
+        lines.append(f'/* a block comment\n   spanning multiple lines */ let generated_call_{i}(a, b) = a + b;')
+    lines.append('')
+    lines.append('in prg {')
+    lines.append('    const data : [u8] = [0];')
+    lines.append('}')
+
+    return '\n'.join(lines)
+
+
+
+@benchmark('modules', '6502', 'a program split across many imported modules, which are read and scanned by `--jobs` worker threads')
+def generate_modules(scale):
+    # Returns a set of files. Like the lexer benchmark, the modules are mostly `let` declarations that are never reduced,
+    # so this measures the work done per module before compiling starts: reading, scanning, and replaying tokens into the parser.
+    modules = 16 * scale
+    items_per_module = 2000
+
+    files = dict()
+
+    lines = list()
+    lines.append('bank prg @ 0x8000 : [constdata; 0x100];')
+    lines.append('')
+    for m in range(modules):
+        lines.append(f'import "module{m}";')
+    lines.append('')
+    lines.append('in prg {')
+    lines.append('    const data : [u8] = [0];')
+    lines.append('}')
+    files['main.wiz'] = '\n'.join(lines)
+
+    for m in range(modules):
+        lines = list()
+        lines.append(f'namespace module{m} {{')
+        for i in range(items_per_module):
+            lines.append(f'    // item {i} of module {m}')
+            lines.append(f'    let item{i} = 0x{i & 0xFFFF:04X} + {i} * shared_identifier_{i % 256} - 0b1010_0101;')
+            lines.append(f'    let name{i} = "module {m}, item {i}";')
+            lines.append(f'    let call{i}(a, b) = a + b * item{i};')
+        lines.append('}')
+        files[f'module{m}.wiz'] = '\n'.join(lines)
+
+    return files
+
+
+
+@benchmark('comprehension', '6502', 'large lookup tables built by array comprehensions over `let` functions')
+def generate_comprehension(scale):
+    tables = 16 * scale
+    items_per_table = 4096
+
+    lines = list()
+    lines.append('bank prg @ 0x0000 : [constdata; 0x100000];')
+    lines.append('')
+    lines.append('let WAVE_BIAS = 0x40;')
+    lines.append('let wave(x, phase) = ((x * 7 + phase) ^ (x >> 3)) & 0x7F;')
+    lines.append('let clamp_low(x) = x & 0xFF;')
+    lines.append('')
+    lines.append('in prg {')
+    for t in range(tables):
+        lines.append(f'    const table{t} : [u8] = [clamp_low(wave(i, {t}) + WAVE_BIAS) for let i in 0 .. {items_per_table - 1}];')
+    lines.append('}')
+
+    return '\n'.join(lines)
+
+
+
+@benchmark('data_tables', '6502', 'large sized-integer tables that are padded, concatenated, indexed and iterated at compile time')
+def generate_data_tables(scale):
+    tables = 8 * scale
+    items_per_table = 8192
+
+    lines = list()
+    lines.append('bank prg @ 0x0000 : [constdata; 0x400000];')
+    lines.append('')
+    for t in range(tables):
+        items = ', '.join(f'0x{(i * 37 + t) & 0xFFFF:04X}u16' for i in range(items_per_table))
+        lines.append(f'let TABLE{t} = [{items}];')
+    lines.append('')
+    lines.append('in prg {')
+    for t in range(tables):
+        lines.append(f'    const table{t} : [u16] = TABLE{t} ~ TABLE{t} ~ [TABLE{t}[{t}]; 0x4000];')
+        lines.append(f'    const low{t} : [u8] = [<:x for let x in TABLE{t}];')
+    lines.append('}')
+
+    return '\n'.join(lines)
+
+
+
+@benchmark('name_resolution', '6502', 'identifiers used deep inside nested namespaces, but defined at the outermost scope')
+def generate_name_resolution(scale):
+    # Every unqualified lookup from the innermost namespace misses in each enclosing scope before it reaches the top.
+    depth = 24
+    constants = 64
+    banks = 4 * scale
+    items_per_bank = 4000
+
+    lines = list()
+    for b in range(banks):
+        lines.append(f'bank prg{b} @ 0x8000 : [constdata; 0x8000];')
+    lines.append('')
+    for c in range(constants):
+        lines.append(f'let C{c} = {c};')
+    lines.append('')
+
+    for b in range(banks):
+        for d in range(depth):
+            lines.append(f'namespace n{b}_{d} {{')
+        lines.append(f'in prg{b} {{')
+        lines.append(f'    func f{b} {{')
+        for i in range(items_per_bank):
+            lines.append(f'        a = C{i % constants} + C{(i * 7) % constants};')
+        lines.append('    }')
+        lines.append('}')
+        lines.append('}' * depth)
+        lines.append('')
+
+    return '\n'.join(lines)
+
+
+
+@benchmark('constant_folding', '6502', 'long compile-time expressions with wide intermediate values, folded into immediate operands')
+def generate_constant_folding(scale):
+    # Every operand is a literal, so each statement is folded by simplifyBinaryArithmeticExpression
+    # before a single load is emitted. The products and shifts push intermediate values well past 32 bits.
+    banks = 4 * scale
+    items_per_bank = 4000
+
+    lines = list()
+    for b in range(banks):
+        lines.append(f'bank prg{b} @ 0x8000 : [constdata; 0x8000];')
+    lines.append('')
+
+    for b in range(banks):
+        lines.append(f'in prg{b} {{')
+        lines.append(f'    func f{b} {{')
+        for i in range(items_per_bank):
+            n = b * items_per_bank + i + 1
+            lines.append(f'        a = ((0x12345678 * {n} + 0x9ABCDEF0) / 0x1234 % 0x10000 + ({n} << 40 >> 37) - 0x7FFFFFFF / {n} * {n} % 0x3FF) & 0xFF;')
+        lines.append('    }')
+        lines.append('}')
+        lines.append('')
+
+    return '\n'.join(lines)
+
+
+
+@benchmark('examples', None, 'each program in the examples/ tree, which exercises the scanner and parser on real-world source')
+def generate_examples(scale):
+    invocations = [
+        Invocation('2600/finalduck', ('-I../common/', 'main.wiz'), '.a26'),
+        Invocation('gb/frogegg', ('-I../common', 'main.wiz'), '.gb'),
+        Invocation('gb/hypercat', ('-I../common', 'main.wiz'), '.gb'),
+        Invocation('gb/snake', ('-I../common', 'main.wiz'), '.gb'),
+        Invocation('gb/xzone', ('-I../common', 'main.wiz'), '.gb'),
+        Invocation('gg/hello', ('-I../common/', 'hello.wiz'), '.gg'),
+        Invocation('nes/hello', ('-I../common', '--system=6502', 'hello.wiz'), '.nes'),
+        Invocation('nes/shmup', ('-I../common', '--system=6502', 'main.wiz'), '.nes'),
+        Invocation('nes/slimes', ('-I../common', '--system=6502', 'main.wiz'), '.nes'),
+        Invocation('pce/hello', ('-I../common', 'main.wiz'), '.pce'),
+    ]
+    return invocations * scale
+
+
+
+def run_benchmark(wiz, bench, source, output_fn, repeat, jobs):
+    job_arguments = ('--jobs', str(jobs)) if jobs is not None else ()
+
+    if isinstance(source, str):
+        commands = [(None, (wiz, '--system', bench.system, '-o', output_fn) + job_arguments + (source,))]
+    else:
+        commands = [
+            (os.path.join(EXAMPLES_DIR, invocation.directory), (os.path.abspath(wiz),) + job_arguments + invocation.arguments + ('-o', output_fn + invocation.extension))
+            for invocation in source
+        ]
+
+    best = None
+
+    for _ in range(repeat):
+        start = time.perf_counter()
+        for directory, arguments in commands:
+            process = subprocess.run(
+                arguments,
+                cwd=directory,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE
+            )
+
+            if process.returncode != 0:
+                print(process.stderr.decode('utf-8'), file=sys.stderr)
+                return None
+        elapsed = time.perf_counter() - start
+
+        if best is None or elapsed < best:
+            best = elapsed
+
+    return best
+
+
+
+def read_program_arguments():
+    parser = argparse.ArgumentParser(description='Times wiz executables on synthetic programs.')
+    parser.add_argument('-w', '--wiz', required=True, action='append',
+                        help='location of wiz executable (may be given more than once to compare builds)')
+    parser.add_argument('-r', '--repeat', type=int, default=3,
+                        help='number of runs per benchmark, the fastest run is reported')
+    parser.add_argument('-s', '--scale', type=int, default=1,
+                        help='multiplier applied to the size of each generated program')
+    parser.add_argument('-j', '--jobs', type=int, default=None,
+                        help='number of threads passed to wiz through `--jobs` (default: not passed)')
+    parser.add_argument('-l', '--list', action='store_true',
+                        help='list available benchmarks and exit')
+    parser.add_argument('benchmarks', nargs='*',
+                        help='names of benchmarks to run (default: all)')
+
+    return parser.parse_args()
+
+
+
+def main():
+    args = read_program_arguments()
+
+    if args.list:
+        for bench in BENCHMARKS:
+            print(f"{bench.name}: {bench.description}")
+        sys.exit(0)
+
+    selected = BENCHMARKS
+    if args.benchmarks:
+        names = set(args.benchmarks)
+        unknown = names - set(bench.name for bench in BENCHMARKS)
+        if unknown:
+            print(f"unknown benchmark(s): {', '.join(sorted(unknown))}", file=sys.stderr)
+            sys.exit(1)
+        selected = [bench for bench in BENCHMARKS if bench.name in names]
+
+    failed = False
+
+    with tempfile.TemporaryDirectory() as temp_dir:
+        for bench in selected:
+            output_fn = os.path.join(temp_dir, bench.name + '.bin')
+            generated = bench.generate(args.scale)
+
+            if isinstance(generated, str):
+                source = os.path.join(temp_dir, bench.name + '.wiz')
+                with open(source, 'w') as fp:
+                    fp.write(generated)
+
+                print(f"{bench.name} ({os.path.getsize(source)} bytes of source):")
+            elif isinstance(generated, dict):
+                module_dir = os.path.join(temp_dir, bench.name)
+                os.makedirs(module_dir, exist_ok=True)
+                for filename, text in generated.items():
+                    with open(os.path.join(module_dir, filename), 'w') as fp:
+                        fp.write(text)
+
+                source = os.path.join(module_dir, 'main.wiz')
+                size = sum(os.path.getsize(os.path.join(module_dir, filename)) for filename in generated)
+                print(f"{bench.name} ({size} bytes of source in {len(generated)} files):")
+            else:
+                source = generated
+                print(f"{bench.name} ({len(generated)} programs):")
+
+            for wiz in args.wiz:
+                elapsed = run_benchmark(wiz, bench, source, output_fn, args.repeat, args.jobs)
+                if elapsed is None:
+                    print(f"\t{wiz}: FAILED")
+                    failed = True
+                else:
+                    print(f"\t{wiz}: {elapsed:.3f}s")
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main();